@@ -64,6 +64,12 @@ defmodule Numy.Fit.SimpleLinear do
 
   var(x) = E[ (x - x̄)² ] = (∑(xᵢ - x̄)²) / n
   """
+  def variance(%Numy.Lapack.Vector{lapack: tensor} = x) do
+    x_mean = Vc.mean(x)
+    sum_sq_dx = Numy.Lapack.Expr.eval({:sum, {:pow, {:-, {:arg, 0}, x_mean}, 2}}, [tensor])
+    sum_sq_dx / (Vc.size(x) - 1)
+  end
+
   def variance(x) do
     x_mean = Vc.mean(x)
     sum_sq_dx = Vc.offset(x,-x_mean) |> Vcm.pow2! |> Vc.sum
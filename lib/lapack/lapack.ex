@@ -98,102 +98,1066 @@ defmodule Numy.Lapack do
     raise "tensor_nrelm/1 not implemented"
   end
 
+  def tensor_shape(_tensor) do
+    raise "tensor_shape/1 not implemented"
+  end
+
+  def tensor_encode(_tensor, _compress_level) do
+    raise "tensor_encode/2 not implemented"
+  end
+
+  def tensor_decode(_binary) do
+    raise "tensor_decode/1 not implemented"
+  end
+
+  @doc """
+  Encode tensor into self-describing binary that can be sent to other node
+  or stored, header with shape is followed by the data.
+
+  Options:
+
+  - `compressed: true` - shuffle bytes and deflate the data
+  - `level: 1..9` - compression level, default is 6
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([2,3])
+      iex(2)> bin = Numy.Lapack.to_binary(t, compressed: true)
+      iex(3)> Numy.Lapack.from_binary(bin)
+      %Numy.Lapack{shape: [2, 3], ...}
+  """
+  def to_binary(tensor, opts \\ []) when is_map(tensor) do
+    level = if Keyword.get(opts, :compressed, false), do: Keyword.get(opts, :level, 6), else: 0
+    try do
+      tensor_encode(tensor.nif_resource, level)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "Decode binary made by `to_binary/2` into new tensor."
+  def from_binary(binary) when is_binary(binary) do
+    try do
+      nif_resource = tensor_decode(binary)
+      %Numy.Lapack{nif_resource: nif_resource, shape: tensor_shape(nif_resource)}
+    rescue
+      _ -> :error
+    end
+  end
+
   def fill_tensor(_tensor, _fill_val) do
     raise "fill/2 not implemented"
   end
 
   @doc """
-  Fill tensor with a scalar.
+  Fill tensor with a scalar.
+
+  ## Examples
+
+      iex(1)> tensor = Numy.Lapack.new_tensor([2,3])
+      iex(2)> Numy.Lapack.fill(tensor, 3.14)
+      iex(3)> Numy.Lapack.data(tensor)
+      [3.14, 3.14, 3.14, 3.14, 3.14, 3.14]
+  """
+  def fill(tensor, val) when is_map(tensor) do
+    try do
+      fill_tensor(tensor.nif_resource, val)
+    rescue
+      _ ->
+      :error
+    end
+  end
+
+  def tensor_data(_tensor, _nelm) do
+    raise "tensor_data/2 not implemented"
+  end
+
+  def data(tensor, nelm \\ -1) when is_map(tensor) do
+    try do
+      tensor_data(tensor.nif_resource, nelm)
+    rescue
+      _ ->
+      :error
+    end
+  end
+
+  def tensor_assign(_tensor, _list) do
+    raise "tensor_assign/2 not implemented"
+  end
+
+  def assign(tensor, list) when is_map(tensor) and is_list(list) do
+    try do
+      tensor_assign(tensor.nif_resource, List.flatten(list))
+    rescue
+      _ ->
+        :error
+    end
+  end
+
+  def tensor_shm_create(_name, _shape) do
+    raise "tensor_shm_create/2 not implemented"
+  end
+
+  def tensor_shm_attach(_name) do
+    raise "tensor_shm_attach/1 not implemented"
+  end
+
+  def tensor_shm_unlink(_name) do
+    raise "tensor_shm_unlink/1 not implemented"
+  end
+
+  def tensor_shm_generation(_tensor) do
+    raise "tensor_shm_generation/1 not implemented"
+  end
+
+  def tensor_shm_begin_update(_tensor) do
+    raise "tensor_shm_begin_update/1 not implemented"
+  end
+
+  def tensor_shm_end_update(_tensor) do
+    raise "tensor_shm_end_update/1 not implemented"
+  end
+
+  @doc """
+  Create tensor in named POSIX shared memory segment, or attach to
+  existing segment with the same shape. Other OS processes on the host
+  can attach to the segment by name and see the same data.
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_shared_tensor("ref_model", [3,5])
+      iex(2)> Numy.Lapack.update_shared(t, fn t -> Numy.Lapack.fill(t, 1.0) end)
+      iex(3)> Numy.Lapack.attach_shared("ref_model") |> Numy.Lapack.data
+      [1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0]
+      iex(4)> Numy.Lapack.unlink_shared("ref_model")
+      :ok
+  """
+  def new_shared_tensor(name, shape) when is_list(shape) do
+    try do
+      case tensor_shm_create(to_charlist(name), shape) do
+        :error -> :error
+        nif_resource -> %Numy.Lapack{nif_resource: nif_resource, shape: shape}
+      end
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "Attach to existing shared memory tensor, shape is read from the segment."
+  def attach_shared(name) do
+    try do
+      case tensor_shm_attach(to_charlist(name)) do
+        :error -> :error
+        nif_resource -> %Numy.Lapack{nif_resource: nif_resource, shape: tensor_shape(nif_resource)}
+      end
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "Remove shared memory segment name, mapped tensors stay valid."
+  def unlink_shared(name) do
+    tensor_shm_unlink(to_charlist(name))
+  end
+
+  @doc """
+  Get generation of shared tensor data, it is odd while update is in progress.
+  Reader can compare generations before and after reading to detect
+  concurrent update.
+  """
+  def shared_generation(tensor) when is_map(tensor) do
+    tensor_shm_generation(tensor.nif_resource)
+  end
+
+  @doc """
+  Update shared tensor data with `fun`, bumping generation counter
+  before and after the update. Returns `:error` if other writer is busy.
+  """
+  def update_shared(tensor, fun) when is_map(tensor) and is_function(fun, 1) do
+    case tensor_shm_begin_update(tensor.nif_resource) do
+      :error -> :error
+      _ ->
+        try do
+          fun.(tensor)
+        after
+          tensor_shm_end_update(tensor.nif_resource)
+        end
+    end
+  end
+
+  @spec blas_drotg(float, float) :: {float,float,float,float}
+  def blas_drotg(_a,_b) do
+    raise "cblas_drotg/2 not implemented"
+  end
+
+  @doc """
+
+      res = generate_plane_rotation(1,2)
+      Keyword.fetch(res, :r | :z | :c | :s)
+  """
+  @spec generate_plane_rotation(number, number) :: :error | Keyword.t()
+  def generate_plane_rotation(a, b) when is_number(a) and is_number(b) do
+    try do
+      {r, z, c, s} = blas_drotg(a/1, b/1)
+      [r: r, z: z, c: c, s: s]
+    rescue
+      _ ->
+      :error
+    end
+  end
+
+  @doc "BLAS copy, yᵢ ← xᵢ, for `num` elements with increments of x and y."
+  @spec blas_dcopy(number, tensor_res, number, tensor_res, number) :: :ok
+  def blas_dcopy(_num, _src, _src_step, _dst, _dst_step) do
+    raise "blas_dcopy/5 not implemented"
+  end
+
+  @doc "BLAS scale, xᵢ ← αxᵢ"
+  @spec blas_dscal(integer, number, tensor_res, integer) :: :ok
+  def blas_dscal(_n, _alpha, _x, _incx) do
+    raise "blas_dscal/4 not implemented"
+  end
+
+  @doc "BLAS axpy, yᵢ ← αxᵢ + yᵢ"
+  @spec blas_daxpy(integer, number, tensor_res, integer, tensor_res, integer) :: :ok
+  def blas_daxpy(_n, _alpha, _x, _incx, _y, _incy) do
+    raise "blas_daxpy/6 not implemented"
+  end
+
+  @doc "BLAS dot product, ∑xᵢyᵢ"
+  @spec blas_ddot(integer, tensor_res, integer, tensor_res, integer) :: float
+  def blas_ddot(_n, _x, _incx, _y, _incy) do
+    raise "blas_ddot/5 not implemented"
+  end
+
+  @doc "BLAS Euclidean norm, √∑xᵢ²"
+  @spec blas_dnrm2(integer, tensor_res, integer) :: float
+  def blas_dnrm2(_n, _x, _incx) do
+    raise "blas_dnrm2/3 not implemented"
+  end
+
+  @doc "BLAS sum of absolute values, ∑|xᵢ|"
+  @spec blas_dasum(integer, tensor_res, integer) :: float
+  def blas_dasum(_n, _x, _incx) do
+    raise "blas_dasum/3 not implemented"
+  end
+
+  @doc "BLAS 0-based index of element with max |xᵢ|, -1 if n is 0"
+  @spec blas_idamax(integer, tensor_res, integer) :: integer
+  def blas_idamax(_n, _x, _incx) do
+    raise "blas_idamax/3 not implemented"
+  end
+
+  @doc "BLAS plane rotation, xᵢ ← cxᵢ + syᵢ, yᵢ ← cyᵢ - sxᵢ"
+  @spec blas_drot(integer, tensor_res, integer, tensor_res, integer, number, number) :: :ok
+  def blas_drot(_n, _x, _incx, _y, _incy, _c, _s) do
+    raise "blas_drot/7 not implemented"
+  end
+
+  @doc "BLAS modified plane rotation, param is `[flag, h11, h21, h12, h22]`"
+  @spec blas_drotm(integer, tensor_res, integer, tensor_res, integer, [number]) :: :ok
+  def blas_drotm(_n, _x, _incx, _y, _incy, _param) do
+    raise "blas_drotm/6 not implemented"
+  end
+
+
+  @doc "BLAS matrix-vector product, y ← α·op(A)·x + β·y, allocates y if it is `nil`"
+  @spec blas_dgemv(boolean, number, tensor_res, tensor_res, number, tensor_res | nil) :: tensor_res
+  def blas_dgemv(_trans, _alpha, _a, _x, _beta, _y) do
+    raise "blas_dgemv/6 not implemented"
+  end
+
+  @doc "BLAS matrix-matrix product, C ← α·op(A)·op(B) + β·C, allocates C if it is `nil`"
+  @spec blas_dgemm(boolean, boolean, number, tensor_res, tensor_res, number, tensor_res | nil) :: tensor_res
+  def blas_dgemm(_trans_a, _trans_b, _alpha, _a, _b, _beta, _c) do
+    raise "blas_dgemm/7 not implemented"
+  end
+
+  @doc """
+  Matrix-vector product y ← α·op(A)·x + β·y.
+
+  Options:
+
+  - `transpose: true` - use Aᵀ instead of A
+  - `alpha: 1.0`, `beta: 0.0`
+  - `out: y` - preallocated output tensor, result is written into it
+
+  ## Examples
+
+      iex(1)> a = Numy.Lapack.new_tensor([3,2])
+      iex(2)> Numy.Lapack.assign(a, [[1,2,3],[4,5,6]])
+      iex(3)> x = Numy.Lapack.new_tensor([3])
+      iex(4)> Numy.Lapack.assign(x, [1,1,1])
+      iex(5)> Numy.Lapack.gemv(a, x) |> Numy.Lapack.data
+      [6.0, 15.0]
+  """
+  def gemv(a, x, opts \\ []) when is_map(a) and is_map(x) do
+    out = Keyword.get(opts, :out)
+    try do
+      res = blas_dgemv(Keyword.get(opts, :transpose, false), Keyword.get(opts, :alpha, 1.0),
+        a.nif_resource, x.nif_resource, Keyword.get(opts, :beta, 0.0),
+        if(out, do: out.nif_resource, else: nil))
+      out || %Numy.Lapack{nif_resource: res, shape: tensor_shape(res)}
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Matrix-matrix product C ← α·op(A)·op(B) + β·C.
+
+  Options:
+
+  - `transpose_a: true`, `transpose_b: true` - use transposed matrix
+  - `alpha: 1.0`, `beta: 0.0`
+  - `out: c` - preallocated output tensor, result is written into it
+  """
+  def gemm(a, b, opts \\ []) when is_map(a) and is_map(b) do
+    out = Keyword.get(opts, :out)
+    try do
+      res = blas_dgemm(Keyword.get(opts, :transpose_a, false),
+        Keyword.get(opts, :transpose_b, false), Keyword.get(opts, :alpha, 1.0),
+        a.nif_resource, b.nif_resource, Keyword.get(opts, :beta, 0.0),
+        if(out, do: out.nif_resource, else: nil))
+      out || %Numy.Lapack{nif_resource: res, shape: tensor_shape(res)}
+    rescue
+      _ -> :error
+    end
+  end
+
+  def batch_matmul(_tensor_a, _tensor_b, _tensor_c) do
+    raise "batch_matmul/3 not implemented"
+  end
+
+  @doc """
+  Multiply stack of small matrices by stack of vectors or matrices
+  in one call, Cᵢ ← Aᵢ×Bᵢ.
+
+  - `a` - matrices of shape `[k, m, batch]`, or one matrix `[k, m]` used for all
+  - `b` - vectors of shape `[k, batch]` or matrices `[n, k, batch]`
+  - `out` - preallocated output of shape `[m, batch]` or `[n, m, batch]`
+
+  ## Examples
+
+      iex(1)> rot = Numy.Lapack.new_tensor([2,2])
+      iex(2)> Numy.Lapack.assign(rot, [[0,-1],[1,0]])
+      iex(3)> points = Numy.Lapack.new_tensor([2,3])
+      iex(4)> Numy.Lapack.assign(points, [[1,0],[0,1],[1,1]])
+      iex(5)> Numy.Lapack.batch_mul(rot, points) |> Numy.Lapack.data
+      [0.0, 1.0, -1.0, 0.0, -1.0, 1.0]
+  """
+  def batch_mul(a, b, out \\ nil) when is_map(a) and is_map(b) do
+    try do
+      res = batch_matmul(a.nif_resource, b.nif_resource, if(out, do: out.nif_resource, else: nil))
+      out || %Numy.Lapack{nif_resource: res, shape: tensor_shape(res)}
+    rescue
+      _ -> :error
+    end
+  end
+
+  def lapack_dgels(_tensor_a, _tensor_b) do
+    raise "lapack_dgels/2 not implemented"
+  end
+
+  def solve_lls(a, b) when is_map(a) and is_map(b) do
+    cond do
+      length(a.shape) != 2 ->
+        :error
+      length(b.shape) != 2 ->
+        :error
+      true ->
+        try do
+          lapack_dgels(a.nif_resource, b.nif_resource)
+        rescue
+          _ ->
+            :error
+        end
+    end
+  end
+
+  def lapack_dgels_batch(_tensor_a, _tensor_b) do
+    raise "lapack_dgels_batch/2 not implemented"
+  end
+
+  @doc """
+  Solve many independent linear least squares problems in one call.
+
+  - `a` - stacked matrices, shape `[n, m, batch]`, m >= n
+  - `b` - stacked right hand sides, shape `[nrhs, m, batch]` or `[m, batch]`
+
+  Like `solve_lls/2`, A and B are overwritten, solution of each
+  system is in its first n rows of B.
+  Returns 0 or `{:error, index, info}` for the first failed system.
+  """
+  def solve_lls_batch(a, b) when is_map(a) and is_map(b) do
+    try do
+      lapack_dgels_batch(a.nif_resource, b.nif_resource)
+    rescue
+      _ -> :error
+    end
+  end
+
+  def lapack_factorize(_tensor_a, _method) do
+    raise "lapack_factorize/2 not implemented"
+  end
+
+  def lapack_factor_solve(_factorization, _tensor_b) do
+    raise "lapack_factor_solve/2 not implemented"
+  end
+
+  @doc """
+  Factorize matrix A once to solve A×X = B for many B.
+  A is copied and is not changed.
+
+  Methods:
+
+  - `:lu` - square A, LU with partial pivoting
+  - `:qr` - A with rows >= columns, solves least squares problem
+  - `:cholesky` - symmetric positive definite A
+
+  Returns factorization or `{:error, info}`.
+
+  ## Examples
+
+      iex(1)> a = Numy.Lapack.new_tensor([2,2])
+      iex(2)> Numy.Lapack.assign(a, [[4,1],[1,3]])
+      iex(3)> f = Numy.Lapack.factorize(a, :cholesky)
+      iex(4)> b = Numy.Lapack.new_tensor([2])
+      iex(5)> Numy.Lapack.assign(b, [1,2])
+      iex(6)> Numy.Lapack.factor_solve(f, b)
+      0
+      iex(7)> Numy.Lapack.data(b)
+      [0.09090909090909091, 0.6363636363636364]
+  """
+  def factorize(a, method \\ :lu) when is_map(a) and method in [:lu, :qr, :cholesky] do
+    try do
+      lapack_factorize(a.nif_resource, method)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Solve A×X = B using factorization made by `factorize/2`,
+  B is overwritten with solution X, for `:qr` solution is in the first
+  columns(A) rows. Returns LAPACK info, 0 on success.
+  """
+  def factor_solve(factorization, b) when is_map(b) do
+    try do
+      lapack_factor_solve(factorization, b.nif_resource)
+    rescue
+      _ -> :error
+    end
+  end
+
+  def tensor_reduce(_tensor, _op, _axes) do
+    raise "tensor_reduce/3 not implemented"
+  end
+
+  @doc """
+  Reduce tensor along axes, returns new tensor without reduced axes.
+
+  - `op` - `:sum`, `:mean`, `:min`, `:max`, `:norm` (L2), `:argmax` or `:argmin`
+  - `axes` - list of indexes into `shape`, or nil for all axes;
+    `:argmax` and `:argmin` take one axis
+
+  ## Examples
+
+      iex(1)> m = Numy.Lapack.new_tensor([3,2])
+      iex(2)> Numy.Lapack.assign(m, [[1,2,3],[4,5,6]])
+      iex(3)> Numy.Lapack.reduce(m, :sum, [0]) |> Numy.Lapack.data
+      [6.0, 15.0]
+      iex(4)> Numy.Lapack.reduce(m, :max, [1]) |> Numy.Lapack.data
+      [4.0, 5.0, 6.0]
+  """
+  def reduce(tensor, op, axes \\ nil) when is_map(tensor) and is_atom(op) do
+    try do
+      wrap_tensor(tensor_reduce(tensor.nif_resource, op, axes))
+    rescue
+      _ -> :error
+    end
+  end
+
+  def tensor_permute(_tensor, _axes) do
+    raise "tensor_permute/2 not implemented"
+  end
+
+  def tensor_reshape(_tensor, _shape) do
+    raise "tensor_reshape/2 not implemented"
+  end
+
+  @doc """
+  Permute tensor axes, `shape` of result is `axes` picked from `shape` of tensor.
+
+  ## Examples
+
+      iex(1)> m = Numy.Lapack.new_tensor([3,2])
+      iex(2)> Numy.Lapack.assign(m, [[1,2,3],[4,5,6]])
+      iex(3)> Numy.Lapack.permute(m, [1,0]) |> Numy.Lapack.data
+      [1.0, 4.0, 2.0, 5.0, 3.0, 6.0]
+  """
+  def permute(tensor, axes) when is_map(tensor) and is_list(axes) do
+    try do
+      wrap_tensor(tensor_permute(tensor.nif_resource, axes))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Transpose matrix, or swap two innermost axes of tensor.
+  """
+  def transpose(tensor) when is_map(tensor) do
+    case length(tensor.shape) do
+      1 -> permute(tensor, [0])
+      2 -> permute(tensor, [1, 0])
+      nd -> permute(tensor, [1, 0 | Enum.to_list(2..(nd - 1))])
+    end
+  end
+
+  @doc """
+  Change shape of tensor without moving data, number of elements stays same.
+
+  Returns new tensor that shares data with `tensor`, in-place updates of
+  either one are seen by both. Shape of `tensor` is not changed.
+  """
+  def reshape(tensor, shape) when is_map(tensor) and is_list(shape) do
+    try do
+      wrap_tensor(tensor_reshape(tensor.nif_resource, shape))
+    rescue
+      _ -> :error
+    end
+  end
+
+  def tensor_eval(_code, _consts, _tensors, _reduce) do
+    raise "tensor_eval/4 not implemented"
+  end
+
+  def tensor_scan(_tensor, _op, _exclusive, _in_place) do
+    raise "tensor_scan/4 not implemented"
+  end
+
+  def tensor_diff(_tensor, _order) do
+    raise "tensor_diff/2 not implemented"
+  end
+
+  @doc """
+  Cumulative `:sum`, `:prod`, `:max` or `:min` along each run of
+  `shape[0]` elements, returns new tensor.
+
+  Exclusive scan shifts result by one, first element is identity
+  (0, 1, -inf, +inf). Sum is compensated.
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([4])
+      iex(2)> Numy.Lapack.assign(t, [1,2,3,4])
+      iex(3)> Numy.Lapack.cumulative(t, :sum) |> Numy.Lapack.data
+      [1.0, 3.0, 6.0, 10.0]
+      iex(4)> Numy.Lapack.cumulative(t, :prod, true) |> Numy.Lapack.data
+      [1.0, 1.0, 2.0, 6.0]
+  """
+  def cumulative(tensor, op, exclusive \\ false) when is_map(tensor) and is_atom(op) do
+    try do
+      wrap_tensor(tensor_scan(tensor.nif_resource, op, exclusive, false))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "In-place `cumulative/3`."
+  def cumulative!(tensor, op, exclusive \\ false) when is_map(tensor) and is_atom(op) do
+    try do
+      :ok = tensor_scan(tensor.nif_resource, op, exclusive, true)
+      tensor
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  n-th order difference along each run of `shape[0]` elements,
+  first dimension of result is shorter by `order`.
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([4])
+      iex(2)> Numy.Lapack.assign(t, [1,4,9,16])
+      iex(3)> Numy.Lapack.diff(t) |> Numy.Lapack.data
+      [3.0, 5.0, 7.0]
+      iex(4)> Numy.Lapack.diff(t, 2) |> Numy.Lapack.data
+      [2.0, 2.0]
+  """
+  def diff(tensor, order \\ 1) when is_map(tensor) and is_integer(order) do
+    try do
+      wrap_tensor(tensor_diff(tensor.nif_resource, order))
+    rescue
+      _ -> :error
+    end
+  end
+
+  def tensor_rolling(_tensor, _op, _window, _step, _min_periods) do
+    raise "tensor_rolling/5 not implemented"
+  end
+
+  @doc """
+  Rolling window `:sum`, `:mean`, `:var`, `:std`, `:min` or `:max`
+  along each run of `shape[0]` elements, O(n) in tensor size.
+
+  Window of `window` elements ends at positions `min_periods - 1`,
+  `min_periods - 1 + step`, ..., first windows are shorter when
+  `min_periods < window`. Variance is sample variance.
+
+  Options:
+
+  - `:step` - distance between windows, default 1
+  - `:min_periods` - elements in the first window, default `window`
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([5])
+      iex(2)> Numy.Lapack.assign(t, [1,2,3,4,5])
+      iex(3)> Numy.Lapack.rolling(t, :mean, 2) |> Numy.Lapack.data
+      [1.5, 2.5, 3.5, 4.5]
+      iex(4)> Numy.Lapack.rolling(t, :max, 3, min_periods: 1, step: 2) |> Numy.Lapack.data
+      [1.0, 3.0, 5.0]
+  """
+  def rolling(tensor, op, window, opts \\ []) when is_map(tensor) and is_atom(op) do
+    step = Keyword.get(opts, :step, 1)
+    min_periods = Keyword.get(opts, :min_periods, window)
+    try do
+      wrap_tensor(tensor_rolling(tensor.nif_resource, op, window, step, min_periods))
+    rescue
+      _ -> :error
+    end
+  end
+
+  def tensor_ewm(_tensor, _alpha, _state) do
+    raise "tensor_ewm/3 not implemented"
+  end
+
+  def tensor_holt(_tensor, _alpha, _beta, _state) do
+    raise "tensor_holt/4 not implemented"
+  end
+
+  @doc """
+  Exponentially weighted moving average and variance,
+  `mean += alpha * (x - mean)`, along each run of `shape[0]` elements;
+  every row of 2-D tensor is separate series.
+
+  Returns `{mean, var, state}`, `mean` and `var` have shape of `tensor`,
+  `state` holds final mean and variance of each series; pass it with
+  next batch to continue the series. Without `state` series start at
+  first element with zero variance.
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([4])
+      iex(2)> Numy.Lapack.assign(t, [1,3,3,3])
+      iex(3)> {mean, _var, _state} = Numy.Lapack.ewm(t, 0.5)
+      iex(4)> Numy.Lapack.data(mean)
+      [1.0, 2.0, 2.5, 2.75]
+  """
+  def ewm(tensor, alpha, state \\ nil) when is_map(tensor) and is_number(alpha) do
+    try do
+      {mean, var, new_state} = tensor_ewm(tensor.nif_resource, alpha, state_resource(state))
+      {wrap_tensor(mean), wrap_tensor(var), wrap_tensor(new_state)}
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Holt double exponential smoothing with level and trend,
+  along each run of `shape[0]` elements; every row of 2-D tensor
+  is separate series.
+
+  Returns `{level, state}`, `level` has shape of `tensor`, `state` holds
+  final level and trend of each series; pass it with next batch
+  to continue the series. Forecast `h` steps ahead is `level + h * trend`.
+  Without `state` level starts at first element and trend at
+  difference of first two.
 
   ## Examples
 
-      iex(1)> tensor = Numy.Lapack.new_tensor([2,3])
-      iex(2)> Numy.Lapack.fill(tensor, 3.14)
-      iex(3)> Numy.Lapack.data(tensor)
-      [3.14, 3.14, 3.14, 3.14, 3.14, 3.14]
+      iex(1)> t = Numy.Lapack.new_tensor([4])
+      iex(2)> Numy.Lapack.assign(t, [1,2,3,4])
+      iex(3)> {level, state} = Numy.Lapack.holt(t, 0.5, 0.5)
+      iex(4)> Numy.Lapack.data(level)
+      [1.0, 2.0, 3.0, 4.0]
+      iex(5)> Numy.Lapack.data(state)
+      [4.0, 1.0]
   """
-  def fill(tensor, val) when is_map(tensor) do
+  def holt(tensor, alpha, beta, state \\ nil)
+  when is_map(tensor) and is_number(alpha) and is_number(beta) do
     try do
-      fill_tensor(tensor.nif_resource, val)
+      {level, new_state} = tensor_holt(tensor.nif_resource, alpha, beta, state_resource(state))
+      {wrap_tensor(level), wrap_tensor(new_state)}
     rescue
-      _ ->
-      :error
+      _ -> :error
     end
   end
 
-  def tensor_data(_tensor, _nelm) do
-    raise "tensor_data/2 not implemented"
+  defp state_resource(nil), do: nil
+  defp state_resource(%Numy.Lapack{nif_resource: res}), do: res
+
+  def tensor_histogram(_tensor, _bins, _weights) do
+    raise "tensor_histogram/3 not implemented"
   end
 
-  def data(tensor, nelm \\ -1) when is_map(tensor) do
+  def tensor_digitize(_tensor, _bins, _right) do
+    raise "tensor_digitize/3 not implemented"
+  end
+
+  @doc """
+  Histogram of each run of `shape[0]` elements.
+
+  `bins` is `{lo, hi, n}` for `n` bins of equal width or tensor of
+  sorted edges. Bin `i` is `[edges[i], edges[i+1])`, the last bin
+  includes its right edge; values outside of edges and NaN are not
+  counted. Result has shape of `tensor` with `shape[0]` replaced
+  by number of bins.
+
+  Options:
+
+  - `:weights` - tensor of same size, counts become sums of weights
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([6])
+      iex(2)> Numy.Lapack.assign(t, [0.5, 1, 1.5, 2, 4, 7])
+      iex(3)> Numy.Lapack.histogram(t, {0, 4, 4}) |> Numy.Lapack.data
+      [1.0, 2.0, 1.0, 1.0]
+  """
+  def histogram(tensor, bins, opts \\ []) when is_map(tensor) do
+    weights = state_resource(Keyword.get(opts, :weights))
     try do
-      tensor_data(tensor.nif_resource, nelm)
+      wrap_tensor(tensor_histogram(tensor.nif_resource, bins_term(bins), weights))
     rescue
-      _ ->
-      :error
+      _ -> :error
     end
   end
 
-  def tensor_assign(_tensor, _list) do
-    raise "tensor_assign/2 not implemented"
+  @doc """
+  Bin index of each element, like numpy `digitize`.
+
+  `bins` is `{lo, hi, n}` or tensor of sorted edges. Index `i` means
+  `edges[i-1] <= x < edges[i]`, 0 is left of all edges and number of
+  edges is right of them (and NaN).
+
+  Options:
+
+  - `:right` - `true` for `edges[i-1] < x <= edges[i]`, default `false`
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([4])
+      iex(2)> Numy.Lapack.assign(t, [-1, 0, 2.5, 9])
+      iex(3)> Numy.Lapack.digitize(t, {0, 4, 4}) |> Numy.Lapack.data
+      [0.0, 1.0, 3.0, 5.0]
+  """
+  def digitize(tensor, bins, opts \\ []) when is_map(tensor) do
+    right = Keyword.get(opts, :right, false)
+    try do
+      wrap_tensor(tensor_digitize(tensor.nif_resource, bins_term(bins), right))
+    rescue
+      _ -> :error
+    end
   end
 
-  def assign(tensor, list) when is_map(tensor) and is_list(list) do
+  defp bins_term({_lo, _hi, _n} = bins), do: bins
+  defp bins_term(%Numy.Lapack{nif_resource: res}), do: res
+
+  def tensor_segment_reduce(_tensor, _ids, _op) do
+    raise "tensor_segment_reduce/3 not implemented"
+  end
+
+  @doc """
+  Reduce values by integer group id: `:sum`, `:mean`, `:count`,
+  `:min` or `:max` of the values of each group.
+
+  `ids` is tensor of same size as `tensor`. Returns `{groups, results}`,
+  tensors of distinct ids in ascending order and result for each.
+  Sorted ids are reduced segment by segment, unsorted ones by hashing.
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([5])
+      iex(2)> Numy.Lapack.assign(t, [1,2,3,4,5])
+      iex(3)> ids = Numy.Lapack.new_tensor([5])
+      iex(4)> Numy.Lapack.assign(ids, [7,3,7,3,1])
+      iex(5)> {groups, sums} = Numy.Lapack.segment_reduce(t, ids, :sum)
+      iex(6)> {Numy.Lapack.data(groups), Numy.Lapack.data(sums)}
+      {[1.0, 3.0, 7.0], [5.0, 6.0, 4.0]}
+  """
+  def segment_reduce(tensor, ids, op) when is_map(tensor) and is_map(ids) and is_atom(op) do
     try do
-      tensor_assign(tensor.nif_resource, List.flatten(list))
+      {groups, results} = tensor_segment_reduce(tensor.nif_resource, ids.nif_resource, op)
+      {wrap_tensor(groups), wrap_tensor(results)}
     rescue
-      _ ->
-        :error
+      _ -> :error
     end
   end
 
-  @spec blas_drotg(float, float) :: {float,float,float,float}
-  def blas_drotg(_a,_b) do
-    raise "cblas_drotg/2 not implemented"
+  # GSL NIFs, wrapped by Numy.SL
+
+  def gsl_bspline_new(_nr_coeffs, _order) do
+    raise "gsl_bspline_new/2 not implemented"
+  end
+
+  def gsl_bspline_fit(_solver, _tensor_x, _tensor_y, _weights) do
+    raise "gsl_bspline_fit/4 not implemented"
+  end
+
+  def gsl_bspline_eval(_solver, _tensor_x, _outside) do
+    raise "gsl_bspline_eval/3 not implemented"
+  end
+
+  def gsl_interp_new(_tensor_x, _tensor_y, _type) do
+    raise "gsl_interp_new/3 not implemented"
+  end
+
+  def gsl_interp_eval(_interp, _tensor_x, _outside) do
+    raise "gsl_interp_eval/3 not implemented"
+  end
+
+  def gsl_fft_real(_tensor_x) do
+    raise "gsl_fft_real/1 not implemented"
+  end
+
+  def gsl_fft_real_inverse(_tensor_z, _n) do
+    raise "gsl_fft_real_inverse/2 not implemented"
+  end
+
+  def gsl_fft_complex(_tensor_z, _inverse) do
+    raise "gsl_fft_complex/2 not implemented"
+  end
+
+  def gsl_fft_convolve(_tensor_x, _tensor_k, _correlate, _mode) do
+    raise "gsl_fft_convolve/4 not implemented"
+  end
+
+  def lapack_eigh(_tensor_a, _subset) do
+    raise "lapack_eigh/2 not implemented"
+  end
+
+  def lapack_svd(_tensor_a) do
+    raise "lapack_svd/1 not implemented"
+  end
+
+  def lapack_rsvd(_tensor_a, _k, _oversample, _power_iters, _seed) do
+    raise "lapack_rsvd/5 not implemented"
+  end
+
+  defp wrap_tensor(nif_resource) do
+    %Numy.Lapack{nif_resource: nif_resource, shape: tensor_shape(nif_resource)}
   end
 
   @doc """
+  Eigenvalues and eigenvectors of symmetric matrix.
 
-      res = generate_plane_rotation(1,2)
-      Keyword.fetch(res, :r | :z | :c | :s)
+  Returns `{w, v}`, eigenvalues `w` in ascending order and eigenvectors
+  as columns of `v`, or `{:error, info}`.
+
+  ## Options
+
+  - `:subset` - range of 0-based eigenvalue indexes, for example `0..2`
+    computes only three smallest eigenpairs
   """
-  @spec generate_plane_rotation(number, number) :: :error | Keyword.t()
-  def generate_plane_rotation(a, b) when is_number(a) and is_number(b) do
+  def eigh(a, opts \\ []) when is_map(a) do
+    subset = case Keyword.get(opts, :subset) do
+      nil -> nil
+      first..last -> {first, last}
+    end
     try do
-      {r, z, c, s} = blas_drotg(a/1, b/1)
-      [r: r, z: z, c: c, s: s]
+      case lapack_eigh(a.nif_resource, subset) do
+        {:error, info} -> {:error, info}
+        {w, v} -> {wrap_tensor(w), wrap_tensor(v)}
+      end
     rescue
-      _ ->
-      :error
+      _ -> :error
     end
   end
 
-  @spec blas_dcopy(number, tensor_res, number, tensor_res, number) :: number
-  def blas_dcopy(_num, _src, _src_step, _dst, _dst_step) do
-    raise "blas_dcopy/5 not implemented"
+  @doc """
+  Thin singular value decomposition A = U×S×Vᵀ.
+
+  Returns `{u, s, vt}` with k = min(rows, cols) singular values
+  in descending order, or `{:error, info}`.
+  """
+  def svd(a) when is_map(a) do
+    try do
+      case lapack_svd(a.nif_resource) do
+        {:error, info} -> {:error, info}
+        {u, s, vt} -> {wrap_tensor(u), wrap_tensor(s), wrap_tensor(vt)}
+      end
+    rescue
+      _ -> :error
+    end
   end
 
+  @doc """
+  Truncated randomized SVD, `k` largest singular triplets of A.
+  Much cheaper than `svd/1` for tall matrices when k is small.
 
-  def lapack_dgels(_tensor_a, _tensor_b) do
-    raise "lapack_dgels/2 not implemented"
+  ## Options
+
+  - `:oversample` - extra sketch columns, default 10
+  - `:power_iters` - power iterations, default 2
+  - `:seed` - random seed, default 0
+  """
+  def randomized_svd(a, k, opts \\ []) when is_map(a) and is_integer(k) do
+    try do
+      case lapack_rsvd(a.nif_resource, k, Keyword.get(opts, :oversample, 10),
+             Keyword.get(opts, :power_iters, 2), Keyword.get(opts, :seed, 0)) do
+        {:error, info} -> {:error, info}
+        {u, s, vt} -> {wrap_tensor(u), wrap_tensor(s), wrap_tensor(vt)}
+      end
+    rescue
+      _ -> :error
+    end
   end
 
-  def solve_lls(a, b) when is_map(a) and is_map(b) do
-    cond do
-      length(a.shape) != 2 ->
-        :error
-      length(b.shape) != 2 ->
-        :error
-      true ->
-        try do
-          lapack_dgels(a.nif_resource, b.nif_resource)
-        rescue
-          _ ->
-            :error
-        end
+  def lapack_covariance(_tensor_x, _correlation) do
+    raise "lapack_covariance/2 not implemented"
+  end
+
+  @doc """
+  Covariance matrix of columns of `x`, rows are observations.
+
+  Computes all pairs at once, unlike `Numy.Fit.SimpleLinear.covariance/2`
+  which takes one pair of vectors.
+  Returns new tensor of shape `[cols, cols]`.
+  """
+  def covariance(x) when is_map(x) do
+    try do
+      wrap_tensor(lapack_covariance(x.nif_resource, false))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Pearson correlation matrix of columns of `x`, rows are observations.
+  Correlation with constant column is 0.
+  """
+  def correlation(x) when is_map(x) do
+    try do
+      wrap_tensor(lapack_covariance(x.nif_resource, true))
+    rescue
+      _ -> :error
+    end
+  end
+
+  def lapack_regress(_tensor_x, _tensor_y, _degree, _weights, _ridge) do
+    raise "lapack_regress/5 not implemented"
+  end
+
+  defp regress(x, y, degree, opts) do
+    weights = Keyword.get(opts, :weights)
+    try do
+      case lapack_regress(x.nif_resource, y.nif_resource, degree,
+             if(weights, do: weights.nif_resource, else: nil),
+             Keyword.get(opts, :ridge, 0.0) / 1) do
+        {:error, info} -> {:error, info}
+        {coef, rss, r2} -> {wrap_tensor(coef), rss, r2}
+      end
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Multiple linear regression y ≈ X×β, solved with QR (dgels).
+
+  `x` is design matrix with one row per observation, add column
+  of ones to fit intercept.
+  Returns `{coefficients, rss, r2}` or `{:error, info}`.
+
+  ## Options
+
+  - `:weights` - tensor of observation weights
+  - `:ridge` - ridge penalty λ, minimizes ‖y - Xβ‖² + λ‖β‖²
+  """
+  def linear_fit(x, y, opts \\ []) when is_map(x) and is_map(y) do
+    regress(x, y, -1, opts)
+  end
+
+  @doc """
+  Polynomial regression y ≈ β₀ + β₁x + … + βₖxᵏ.
+
+  Returns `{coefficients, rss, r2}` with coefficients in increasing
+  power order, or `{:error, info}`. Takes same options as `linear_fit/3`,
+  ridge does not penalize β₀.
+  """
+  def poly_fit(x, y, degree, opts \\ []) when is_map(x) and is_map(y) and degree >= 0 do
+    regress(x, y, degree, opts)
+  end
+
+  def online_lsq_new(_nr_coef, _forgetting) do
+    raise "online_lsq_new/2 not implemented"
+  end
+
+  def online_lsq_update(_state, _tensor_x, _tensor_y) do
+    raise "online_lsq_update/3 not implemented"
+  end
+
+  def online_lsq_solve(_state) do
+    raise "online_lsq_solve/1 not implemented"
+  end
+
+  @doc """
+  Create incremental least squares state for `nr_coef` coefficients.
+
+  Rows are absorbed by `online_update/3` in O(p²) each,
+  history is not kept. With `forgetting` λ < 1 weight of
+  row k updates ago is λᵏ.
+
+  `nr_coef` is at most 23170, p×p matrix R must fit in a tensor.
+  """
+  def online_fit(nr_coef, forgetting \\ 1.0) when is_integer(nr_coef) do
+    try do
+      online_lsq_new(nr_coef, forgetting / 1)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Add rows of `x`, shape `[p, k]` or `[p]`, with responses `y`.
+  """
+  def online_update(state, x, y) when is_map(x) and is_map(y) do
+    try do
+      online_lsq_update(state, x.nif_resource, y.nif_resource)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Current coefficients, returns `{coefficients, rss, count}`
+  or `{:error, index}` when fewer than p independent rows were added.
+  """
+  def online_solve(state) do
+    try do
+      case online_lsq_solve(state) do
+        {:error, info} -> {:error, info}
+        {coef, rss, count} -> {wrap_tensor(coef), rss, count}
+      end
+    rescue
+      _ -> :error
     end
   end
 
+  @doc """
+  In-place elementwise `a += b`, same for `vector_sub/2`, `vector_mul/2`
+  and `vector_div/2`.
+
+  If tensors have different number of elements, `b` is broadcast
+  to shape of `a` numpy-style: each dimension of `b` is equal to `a`'s
+  or 1, for example `[cols]` bias row is added to every row of
+  `[cols, rows]` matrix and `[1, rows]` column to every column.
+  """
   def vector_add(_tensor_a, _tensor_b) do
     raise "vector_add/2 not implemented"
   end
@@ -273,8 +1237,72 @@ defmodule Numy.Lapack do
     raise "vector_heaviside/2 not implemented"
   end
 
-  def vector_sigmoid(_tensor) do
-    raise "vector_sigmoid/1 not implemented"
+  def vector_sigmoid(_tensor, _accuracy \\ :accurate) do
+    raise "vector_sigmoid/2 not implemented"
+  end
+
+  def vector_exp(_tensor, _accuracy) do
+    raise "vector_exp/2 not implemented"
+  end
+
+  def vector_log(_tensor, _accuracy) do
+    raise "vector_log/2 not implemented"
+  end
+
+  def vector_tanh(_tensor, _accuracy) do
+    raise "vector_tanh/2 not implemented"
+  end
+
+  def vector_softmax(_tensor, _accuracy) do
+    raise "vector_softmax/2 not implemented"
+  end
+
+  def vector_logsumexp(_tensor, _accuracy) do
+    raise "vector_logsumexp/2 not implemented"
+  end
+
+  @doc """
+  Apply `fun` to every element of tensor in place.
+
+  - `fun` - `:exp`, `:log`, `:tanh`, `:sigmoid`, `:softmax` or
+    `{:pow, p}`, softmax normalizes each run of `shape[0]` elements
+  - `accuracy` - `:accurate` (about 1 ULP for exp and log) or `:fast`;
+    accurate pow is vectorized only for small integer powers and 0.5
+
+  ## Examples
+
+      iex(1)> t = Numy.Lapack.new_tensor([3])
+      iex(2)> Numy.Lapack.assign(t, [0,1,2])
+      iex(3)> Numy.Lapack.apply!(t, :exp) |> Numy.Lapack.data
+      [1.0, 2.7182818284590455, 7.38905609893065]
+  """
+  def apply!(tensor, fun, accuracy \\ :accurate) when is_map(tensor) do
+    try do
+      :ok = case fun do
+        :exp -> vector_exp(tensor.nif_resource, accuracy)
+        :log -> vector_log(tensor.nif_resource, accuracy)
+        :tanh -> vector_tanh(tensor.nif_resource, accuracy)
+        :sigmoid -> vector_sigmoid(tensor.nif_resource, accuracy)
+        :softmax -> vector_softmax(tensor.nif_resource, accuracy)
+        {:pow, p} -> vector_pow(tensor.nif_resource, p, accuracy)
+      end
+      tensor
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  log(sum(exp(x))) of each run of `shape[0]` elements, without overflow.
+
+  Returns new tensor of `shape` without first dimension.
+  """
+  def logsumexp(tensor, accuracy \\ :accurate) when is_map(tensor) do
+    try do
+      wrap_tensor(vector_logsumexp(tensor.nif_resource, accuracy))
+    rescue
+      _ -> :error
+    end
   end
 
   def vector_sort(_tensor) do
@@ -306,8 +1334,8 @@ defmodule Numy.Lapack do
     raise "vector_abs/1 not implemented"
   end
 
-  def vector_pow(_tensor, _power) do
-    raise "vector_pow/2 not implemented"
+  def vector_pow(_tensor, _power, _accuracy \\ :accurate) do
+    raise "vector_pow/3 not implemented"
   end
 
   def vector_pow2(_tensor) do
@@ -361,3 +1389,24 @@ defimpl Numy.Tz, for: Numy.Lapack do
     Numy.Lapack.data(tensor, nelm)
   end
 end
+
+# Mx protocol implementation
+#
+defimpl Numy.Mx, for: Numy.Lapack do
+
+  def nrows(%Numy.Lapack{shape: [_]}), do: 1
+  def nrows(%Numy.Lapack{shape: [_, rows]}), do: rows
+
+  def ncols(%Numy.Lapack{shape: [cols | _]}), do: cols
+
+  def mul(a, b) do
+    Numy.Lapack.gemm(a, b)
+  end
+
+  def mul_vector(a, %Numy.Lapack.Vector{lapack: x}) do
+    case Numy.Lapack.gemv(a, x) do
+      :error -> :error
+      y -> Numy.Lapack.Vector.make_from_nif_res(y.nif_resource)
+    end
+  end
+end
@@ -0,0 +1,104 @@
+defmodule Numy.Lapack.Expr do
+  @moduledoc """
+  Fused elementwise expressions over LAPACK tensors.
+
+  Expression is compiled into bytecode once, NIF evaluates it tile by tile
+  in one pass over memory, without temporary tensors.
+
+  Expression terms:
+
+  - `{:arg, i}` - i-th input tensor
+  - number - constant
+  - `{op, a, b}` - `:+`, `:-`, `:*`, `:/`, `:pow`,
+    comparisons `:<`, `:<=`, `:>`, `:>=`, `:==`, `:!=` give 1.0 or 0.0
+  - `{op, a}` - `:neg` (or `:-`), `:abs`, `:exp`, `:log`, `:tanh`, `:sigmoid`
+
+  Top level `{:sum, e}`, `{:mean, e}`, `{:min, e}` or `{:max, e}`
+  reduces the result to a number.
+
+  ## Examples
+
+      iex(1)> x = Numy.Lapack.new_tensor([3])
+      iex(2)> Numy.Lapack.assign(x, [1,2,3])
+      iex(3)> Numy.Lapack.Expr.eval({:sum, {:pow, {:-, {:arg, 0}, 2.0}, 2}}, [x])
+      2.0
+  """
+
+  defstruct [:code, :consts, :reduce]
+
+  # must match Opcode in nifs/tensor/expr.cpp
+  @op_arg 0
+  @op_const 1
+  @binary_ops %{:+ => 2, :- => 3, :* => 4, :/ => 5, :pow => 6,
+                :< => 7, :<= => 8, :> => 9, :>= => 10, :== => 11, :!= => 12}
+  @unary_ops %{:neg => 13, :- => 13, :abs => 14, :exp => 15, :sigmoid => 16,
+                :log => 17, :tanh => 18}
+
+  @binary_names Map.keys(@binary_ops)
+  @unary_names Map.keys(@unary_ops)
+
+  @reductions [:sum, :mean, :min, :max]
+
+  @doc "Compile expression into `%Numy.Lapack.Expr{}`."
+  def compile({red, expr}) when red in @reductions do
+    %{compile(expr) | reduce: red}
+  end
+
+  def compile(expr) do
+    {code, consts} = emit(expr, {[], []})
+    %Numy.Lapack.Expr{
+      code: code |> Enum.reverse |> :binary.list_to_bin,
+      consts: Enum.reverse(consts),
+      reduce: nil}
+  end
+
+  defp emit(x, {code, consts}) when is_number(x) do
+    if length(consts) > 255, do: raise ArgumentError, message: "too many constants"
+    {[length(consts), @op_const | code], [x * 1.0 | consts]}
+  end
+
+  defp emit({:arg, i}, {code, consts}) when is_integer(i) and i in 0..255 do
+    {[i, @op_arg | code], consts}
+  end
+
+  defp emit({op, a, b}, acc) when op in @binary_names do
+    {code, consts} = emit(b, emit(a, acc))
+    {[@binary_ops[op] | code], consts}
+  end
+
+  defp emit({op, a}, acc) when op in @unary_names do
+    {code, consts} = emit(a, acc)
+    {[@unary_ops[op] | code], consts}
+  end
+
+  defp emit(expr, _acc) do
+    raise ArgumentError, message: "bad expression #{inspect(expr)}"
+  end
+
+  @doc """
+  Evaluate expression over list of tensors with same number of elements.
+
+  Returns new tensor of the shape of the first input, or number
+  when expression has final reduction, `:error` on bad arguments.
+  """
+  def eval(%Numy.Lapack.Expr{} = expr, tensors) when is_list(tensors) do
+    try do
+      res = Numy.Lapack.tensor_eval(expr.code, expr.consts,
+        Enum.map(tensors, fn t -> t.nif_resource end), expr.reduce)
+      case expr.reduce do
+        nil -> %Numy.Lapack{nif_resource: res, shape: hd(tensors).shape}
+        _ -> res
+      end
+    rescue
+      _ -> :error
+    end
+  end
+
+  def eval(expr, tensors) when is_list(tensors) do
+    try do
+      eval(compile(expr), tensors)
+    rescue
+      _ -> :error
+    end
+  end
+end
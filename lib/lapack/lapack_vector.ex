@@ -81,11 +81,39 @@ defmodule Numy.Lapack.Vector do
     %Numy.Lapack.Vector{nelm: nrelm, lapack: %Numy.Lapack{nif_resource: res, shape: [nrelm]}}
   end
 
+  @doc """
+  Encode vector into binary, see `Numy.Lapack.to_binary/2`.
+
+  ## Examples
+
+      iex(1)> v = Numy.Lapack.Vector.new(1..5)
+      iex(2)> Numy.Lapack.Vector.to_binary(v, compressed: true) |> Numy.Lapack.Vector.from_binary
+      #Vector<size=5, [1.0, 2.0, 3.0, 4.0, 5.0]>
+  """
+  def to_binary(v, opts \\ []) when is_map(v) do
+    Numy.Lapack.to_binary(v.lapack, opts)
+  end
+
+  @doc "Decode vector from binary made by `to_binary/2`, `:error` on bad binary."
+  def from_binary(binary) when is_binary(binary) do
+    try do
+      make_from_nif_res(Numy.Lapack.tensor_decode(binary))
+    rescue
+      _ -> :error
+    end
+  end
+
   def save_to_file(v, filename) when is_map(v) do
     Numy.Lapack.tensor_save_to_file(v.lapack.nif_resource, filename)
   end
 
   @doc """
+  Load vector saved by `save_to_file/2`.
+
+  File holds same bytes as `to_binary/1`: header with magic, version
+  and shape, then data. Files saved by older versions (raw tensor
+  header without version) are still read. Files of other format
+  give `{:error, :unsupported_format}`.
 
   ## Examples
 
@@ -97,8 +125,11 @@ defmodule Numy.Lapack.Vector do
       #Vector<size=100, [1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, ...]>
   """
   def load_from_file(filename) do
-    res = Numy.Lapack.tensor_load_from_file(filename)
-    make_from_nif_res(res)
+    case Numy.Lapack.tensor_load_from_file(filename) do
+      :error -> :error
+      {:error, reason} -> {:error, reason}
+      res -> make_from_nif_res(res)
+    end
   end
 
 
@@ -1,5 +1,28 @@
 defprotocol Numy.Mx do
   @moduledoc """
-  Interface to Matrix
+  Interface to Matrix.
+
+  Matrix shape is `[ncols, nrows]` and elements are stored row by row.
   """
+
+  @doc "Number of rows"
+  def nrows(m)
+
+  @doc "Number of columns"
+  def ncols(m)
+
+  @doc """
+  Matrix product, C ← A×B
+
+  ## Examples
+
+      iex(1)> a = Numy.Lapack.new_tensor([2,2])
+      iex(2)> Numy.Lapack.assign(a, [[1,2],[3,4]])
+      iex(3)> Numy.Mx.mul(a, a) |> Numy.Lapack.data
+      [7.0, 10.0, 15.0, 22.0]
+  """
+  def mul(a, b)
+
+  @doc "Matrix-vector product, y ← A×x, x and y are vectors"
+  def mul_vector(a, x)
 end
@@ -31,4 +31,163 @@ defmodule Numy.SL do
   def create_tensor(_tensor_struct) do
     raise "tensor_create/1 not implemented"
   end
+
+  # GSL NIFs are built into Numy.Lapack library, they take
+  # and return its tensor resources without copying.
+  alias Numy.Lapack, as: L
+
+  defp wrap(res), do: %Numy.Lapack{nif_resource: res, shape: L.tensor_shape(res)}
+
+  # `:outside` option: :clamp or fill value, NIFs take float fill
+  defp outside(opts) do
+    case Keyword.get(opts, :outside, :clamp) do
+      :clamp -> :clamp
+      fill when is_number(fill) -> fill / 1
+    end
+  end
+
+  @doc """
+  Create smoothing B-spline solver with `nr_coeffs` basis functions
+  of given order (4 is cubic). Solver keeps its workspaces,
+  reuse it for many fits.
+  """
+  def new_bspline(nr_coeffs, order \\ 4) when is_integer(nr_coeffs) and is_integer(order) do
+    try do
+      L.gsl_bspline_new(nr_coeffs, order)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Fit B-spline to points `x`, `y` (`%Numy.Lapack{}` tensors),
+  breakpoints are uniform over range of x.
+
+  Returns `{chisq, r2, dof}` or `{:error, gsl_code}`.
+
+  ## Options
+
+  - `:weights` - tensor of weights
+  """
+  def fit_bspline(solver, x, y, opts \\ []) when is_map(x) and is_map(y) do
+    weights = Keyword.get(opts, :weights)
+    try do
+      L.gsl_bspline_fit(solver, x.nif_resource, y.nif_resource,
+        if(weights, do: weights.nif_resource, else: nil))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Evaluate fitted B-spline at all points of tensor `x`,
+  returns new `%Numy.Lapack{}` tensor.
+
+  ## Options
+
+  - `:outside` - value for `x` outside of fitted range, `:clamp` (default)
+    takes value at the nearest end of range, a number is used as is
+  """
+  def eval_bspline(solver, x, opts \\ []) when is_map(x) do
+    try do
+      wrap(L.gsl_bspline_eval(solver, x.nif_resource, outside(opts)))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Build interpolant through knots `x` (strictly increasing) and `y`.
+  Type is `:linear`, `:cspline` (natural cubic spline) or `:akima`.
+
+  Returns interpolant or `{:error, gsl_code}`.
+  """
+  def new_interp(x, y, type \\ :cspline) when is_map(x) and is_map(y) do
+    try do
+      L.gsl_interp_new(x.nif_resource, y.nif_resource, type)
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Evaluate interpolant at all points of tensor `x`, returns new
+  `%Numy.Lapack{}` tensor.
+  Sorted `x`, like a resampling grid, is the fastest.
+
+  ## Options
+
+  - `:outside` - value for `x` outside of knots range, `:clamp` (default)
+    takes value at the nearest knot, a number is used as is
+  """
+  def interp(interpolant, x, opts \\ []) when is_map(x) do
+    try do
+      wrap(L.gsl_interp_eval(interpolant, x.nif_resource, outside(opts)))
+    rescue
+      _ -> :error
+    end
+  end
+
+  defp fft_result({:error, code}), do: {:error, code}
+  defp fft_result(res), do: wrap(res)
+
+  @doc """
+  FFT of real signal `x` of shape `[n]`, or of each row of `[n, rows]`.
+
+  Returns spectrum of n/2+1 complex values as interleaved (re, im)
+  pairs, tensor of shape `[2, n/2+1]` or `[2, n/2+1, rows]`.
+  Wavetables are cached per length, repeated transforms of the same
+  length do not re-plan.
+  """
+  def rfft(x) when is_map(x) do
+    try do
+      fft_result(L.gsl_fft_real(x.nif_resource))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "Inverse of `rfft/1`, `n` is length of real signal."
+  def irfft(z, n) when is_map(z) and is_integer(n) do
+    try do
+      fft_result(L.gsl_fft_real_inverse(z.nif_resource, n))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  FFT of complex signal, tensor `[2, n]` or `[2, n, rows]`
+  of (re, im) pairs. Option `inverse: true` computes inverse
+  transform scaled by 1/n.
+  """
+  def fft(z, opts \\ []) when is_map(z) do
+    try do
+      fft_result(L.gsl_fft_complex(z.nif_resource, Keyword.get(opts, :inverse, false)))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc """
+  Convolution of `x` with kernel `k`, mode is `:full`, `:same`
+  or `:valid` like numpy.convolve. Short kernels are convolved
+  directly, long ones with FFT.
+  """
+  def convolve(x, k, mode \\ :full) when is_map(x) and is_map(k) do
+    try do
+      fft_result(L.gsl_fft_convolve(x.nif_resource, k.nif_resource, false, mode))
+    rescue
+      _ -> :error
+    end
+  end
+
+  @doc "Cross-correlation of `x` and `k`, same modes as `convolve/3`."
+  def correlate(x, k, mode \\ :full) when is_map(x) and is_map(k) do
+    try do
+      fft_result(L.gsl_fft_convolve(x.nif_resource, k.nif_resource, true, mode))
+    rescue
+      _ -> :error
+    end
+  end
 end
@@ -0,0 +1,438 @@
+/**
+ * @file
+ * @brief     FFT, convolution and correlation with GSL.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * GSL mixed-radix FFT needs wavetable (trigonometric factors)
+ * and workspace for each transform length. Creating them costs more
+ * than a short transform, so they are kept in per-thread plan cache
+ * keyed by length and reused by all calls on the same scheduler thread.
+ *
+ * Complex data is stored in tensors as interleaved (re, im) pairs,
+ * so complex vector of n elements is tensor [2, n]. 2-D input transforms
+ * each row, [n, rows] real or [2, n, rows] complex.
+ *
+ * Convolution of long signals multiplies spectra of zero-padded inputs,
+ * padded length has only factors 2, 3 and 5, which GSL handles best.
+ * Kernels shorter than DIRECT_MAX_KERNEL are convolved directly,
+ * O(n·m) beats O(L·log L) there.
+ */
+#include "gsl/fft.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <gsl/gsl_fft_complex.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+/// Wavetables and workspaces for one transform length, created on first use.
+struct FFTPlan
+{
+    const size_t n;
+
+    gsl_fft_real_wavetable*        realWt   {nullptr};
+    gsl_fft_halfcomplex_wavetable* hcWt     {nullptr};
+    gsl_fft_real_workspace*        realWs   {nullptr};
+    gsl_fft_complex_wavetable*     cplxWt   {nullptr};
+    gsl_fft_complex_workspace*     cplxWs   {nullptr};
+
+    explicit FFTPlan(size_t len): n(len) {}
+
+    ~FFTPlan() {
+        if (cplxWs != nullptr) gsl_fft_complex_workspace_free(cplxWs);
+        if (cplxWt != nullptr) gsl_fft_complex_wavetable_free(cplxWt);
+        if (realWs != nullptr) gsl_fft_real_workspace_free(realWs);
+        if (hcWt != nullptr) gsl_fft_halfcomplex_wavetable_free(hcWt);
+        if (realWt != nullptr) gsl_fft_real_wavetable_free(realWt);
+    }
+
+    FFTPlan(const FFTPlan&) = delete;
+    FFTPlan& operator=(const FFTPlan&) = delete;
+
+    bool real() {
+        if (realWt == nullptr) realWt = gsl_fft_real_wavetable_alloc(n);
+        if (realWs == nullptr) realWs = gsl_fft_real_workspace_alloc(n);
+        return realWt != nullptr and realWs != nullptr;
+    }
+
+    bool halfcomplex() {
+        if (hcWt == nullptr) hcWt = gsl_fft_halfcomplex_wavetable_alloc(n);
+        if (realWs == nullptr) realWs = gsl_fft_real_workspace_alloc(n);
+        return hcWt != nullptr and realWs != nullptr;
+    }
+
+    bool complex() {
+        if (cplxWt == nullptr) cplxWt = gsl_fft_complex_wavetable_alloc(n);
+        if (cplxWs == nullptr) cplxWs = gsl_fft_complex_workspace_alloc(n);
+        return cplxWt != nullptr and cplxWs != nullptr;
+    }
+};
+
+/// Per-thread plans, least recently used plan is dropped when cache is full.
+class FFTPlanCache
+{
+    static constexpr size_t MAX_PLANS = 16;
+
+    std::vector<FFTPlan*> plans_; ///< most recently used last
+
+public:
+    ~FFTPlanCache() {
+        for (FFTPlan* plan : plans_) delete plan;
+    }
+
+    static FFTPlanCache& local() {
+        thread_local FFTPlanCache cache;
+        return cache;
+    }
+
+    FFTPlan& get(size_t n) {
+        for (size_t i = plans_.size(); i-- > 0;) {
+            if (plans_[i]->n == n) {
+                FFTPlan* plan = plans_[i];
+                plans_.erase(plans_.begin() + i);
+                plans_.push_back(plan);
+                return *plan;
+            }
+        }
+        if (plans_.size() == MAX_PLANS) {
+            delete plans_.front();
+            plans_.erase(plans_.begin());
+        }
+        plans_.push_back(new FFTPlan(n));
+        return *plans_.back();
+    }
+
+    /// Work buffer reused between calls.
+    std::vector<double> buf;
+};
+
+/// Halfcomplex array of length n to interleaved n/2+1 complex values.
+void unpack_halfcomplex(const double* hc, size_t n, double* z)
+{
+    z[0] = hc[0];
+    z[1] = 0.0;
+    for (size_t k = 1; k < (n + 1) / 2; ++k) {
+        z[2 * k]     = hc[2 * k - 1];
+        z[2 * k + 1] = hc[2 * k];
+    }
+    if (n % 2 == 0) {
+        z[n]     = hc[n - 1];
+        z[n + 1] = 0.0;
+    }
+}
+
+/// Interleaved n/2+1 complex values to halfcomplex array of length n.
+void pack_halfcomplex(const double* z, size_t n, double* hc)
+{
+    hc[0] = z[0];
+    for (size_t k = 1; k < (n + 1) / 2; ++k) {
+        hc[2 * k - 1] = z[2 * k];
+        hc[2 * k]     = z[2 * k + 1];
+    }
+    if (n % 2 == 0) {
+        hc[n - 1] = z[n];
+    }
+}
+
+/// Pointwise product of two halfcomplex spectra, result in a.
+void multiply_halfcomplex(double* a, const double* b, size_t n)
+{
+    a[0] *= b[0];
+    for (size_t k = 1; k < (n + 1) / 2; ++k) {
+        const double re = a[2 * k - 1] * b[2 * k - 1] - a[2 * k] * b[2 * k];
+        const double im = a[2 * k - 1] * b[2 * k] + a[2 * k] * b[2 * k - 1];
+        a[2 * k - 1] = re;
+        a[2 * k]     = im;
+    }
+    if (n % 2 == 0) {
+        a[n - 1] *= b[n - 1];
+    }
+}
+
+/// Smallest 2ᵃ3ᵇ5ᶜ >= n.
+size_t good_fft_size(size_t n)
+{
+    size_t best = 1;
+    while (best < n) best *= 2;
+    for (size_t p5 = 1; p5 < best; p5 *= 5) {
+        for (size_t p35 = p5; p35 < best; p35 *= 3) {
+            size_t m = p35;
+            while (m < n) m *= 2;
+            best = std::min(best, m);
+        }
+    }
+    return best;
+}
+
+ERL_NIF_TERM make_error(ErlNifEnv* env, int status)
+{
+    return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, status));
+}
+
+} // anonymous namespace
+
+/**
+ * Forward FFT of real signal.
+ *
+ * argv[0] - x, tensor [n] or [n, rows]
+ *
+ * Returns complex spectrum of n/2+1 elements, tensor [2, n/2+1]
+ * or [2, n/2+1, rows]; or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_fft_real(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorX == nullptr or !tensorX->isValid() or tensorX->nrDims > 2) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n = tensorX->shape[0];
+    const size_t rows = tensorX->nr_rows();
+    const size_t m = n / 2 + 1;
+
+    ERL_NIF_TERM nifZ;
+    const unsigned shapeZ[3] = {2, (unsigned) m, (unsigned) rows};
+    numy::Tensor* tensorZ = numy::tnsr::newTensor(env, tensorX->nrDims + 1, shapeZ, nifZ);
+
+    FFTPlanCache& cache = FFTPlanCache::local();
+    FFTPlan& plan = cache.get(n);
+
+    if (tensorZ == nullptr or !plan.real()) {
+        return enif_make_badarg(env);
+    }
+
+    cache.buf.resize(n);
+    double* hc = cache.buf.data();
+
+    for (size_t r = 0; r < rows; ++r) {
+        std::memcpy(hc, (const double*) tensorX->data + r * n, sizeof(double) * n);
+        int status = gsl_fft_real_transform(hc, 1, n, plan.realWt, plan.realWs);
+        if (status != GSL_SUCCESS) return make_error(env, status);
+        unpack_halfcomplex(hc, n, tensorZ->dbl_data() + r * 2 * m);
+    }
+
+    return nifZ;
+}
+
+/**
+ * Inverse FFT of spectrum of real signal.
+ *
+ * argv[0] - z, complex spectrum tensor [2, n/2+1] or [2, n/2+1, rows]
+ * argv[1] - n, length of real signal
+ *
+ * Returns real signal, tensor [n] or [n, rows]; or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_fft_real_inverse(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorZ = numy::tnsr::getTensor(env, argv[0]);
+    unsigned n {0};
+
+    if (tensorZ == nullptr or !tensorZ->isValid() or
+        tensorZ->nrDims < 2 or tensorZ->nrDims > 3 or tensorZ->shape[0] != 2 or
+        !enif_get_uint(env, argv[1], &n) or n == 0 or tensorZ->shape[1] != n / 2 + 1)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const size_t m = n / 2 + 1;
+    const size_t rows = (tensorZ->nrDims == 3)? tensorZ->shape[2] : 1;
+
+    ERL_NIF_TERM nifX;
+    const unsigned shapeX[2] = {n, (unsigned) rows};
+    numy::Tensor* tensorX = numy::tnsr::newTensor(env, tensorZ->nrDims - 1, shapeX, nifX);
+
+    FFTPlan& plan = FFTPlanCache::local().get(n);
+
+    if (tensorX == nullptr or !plan.halfcomplex()) {
+        return enif_make_badarg(env);
+    }
+
+    for (size_t r = 0; r < rows; ++r) {
+        double* x = tensorX->dbl_data() + r * n;
+        pack_halfcomplex((const double*) tensorZ->data + r * 2 * m, n, x);
+        int status = gsl_fft_halfcomplex_inverse(x, 1, n, plan.hcWt, plan.realWs);
+        if (status != GSL_SUCCESS) return make_error(env, status);
+    }
+
+    return nifX;
+}
+
+/**
+ * Forward or inverse FFT of complex signal.
+ *
+ * argv[0] - z, tensor [2, n] or [2, n, rows] of (re, im) pairs
+ * argv[1] - true for inverse transform, it is scaled by 1/n
+ *
+ * Returns new tensor of same shape or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_fft_complex(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorZ = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorZ == nullptr or !tensorZ->isValid() or
+        tensorZ->nrDims < 2 or tensorZ->nrDims > 3 or tensorZ->shape[0] != 2)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const bool inverse = enif_is_identical(argv[1], numy::tnsr::getTrueAtom(env));
+    const size_t n = tensorZ->shape[1];
+    const size_t rows = (tensorZ->nrDims == 3)? tensorZ->shape[2] : 1;
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, tensorZ->nrDims, tensorZ->shape, nifOut);
+
+    FFTPlan& plan = FFTPlanCache::local().get(n);
+
+    if (tensorOut == nullptr or !plan.complex()) {
+        return enif_make_badarg(env);
+    }
+
+    std::memcpy(tensorOut->data, tensorZ->data, tensorZ->dataSize);
+
+    for (size_t r = 0; r < rows; ++r) {
+        double* z = tensorOut->dbl_data() + r * 2 * n;
+        int status = inverse ?
+            gsl_fft_complex_inverse(z, 1, n, plan.cplxWt, plan.cplxWs) :
+            gsl_fft_complex_forward(z, 1, n, plan.cplxWt, plan.cplxWs);
+        if (status != GSL_SUCCESS) return make_error(env, status);
+    }
+
+    return nifOut;
+}
+
+/**
+ * Convolution or cross-correlation of real signals.
+ *
+ * argv[0] - x, tensor of n elements
+ * argv[1] - k, kernel tensor of m elements
+ * argv[2] - true for cross-correlation, false for convolution
+ * argv[3] - mode, atom :full (n+m-1 elements), :same (max(n,m))
+ *           or :valid (max(n,m)-min(n,m)+1), same as numpy.convolve
+ *
+ * Returns new 1-D tensor or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_convolve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    static constexpr size_t DIRECT_MAX_KERNEL = 64;
+
+    if (argc != 4) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[0]);
+    const numy::Tensor* tensorK = numy::tnsr::getTensor(env, argv[1]);
+
+    char mode[8];
+    if (tensorX == nullptr or !tensorX->isValid() or
+        tensorK == nullptr or !tensorK->isValid() or
+        !enif_get_atom(env, argv[3], mode, sizeof(mode), ERL_NIF_LATIN1))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const bool correlate = enif_is_identical(argv[2], numy::tnsr::getTrueAtom(env));
+
+    const size_t n = tensorX->nrElements;
+    const size_t m = tensorK->nrElements;
+    const size_t full = n + m - 1;
+
+    size_t offset, len;
+    if (0 == strcmp(mode, "full")) {
+        offset = 0; len = full;
+    }
+    else if (0 == strcmp(mode, "same")) {
+        len = std::max(n, m); offset = (full - len) / 2;
+    }
+    else if (0 == strcmp(mode, "valid")) {
+        len = std::max(n, m) - std::min(n, m) + 1; offset = std::min(n, m) - 1;
+    }
+    else {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifOut;
+    const unsigned shapeOut[1] = {(unsigned) len};
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, 1, shapeOut, nifOut);
+
+    if (tensorOut == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* x = (const double*) tensorX->data;
+    const double* kernel = (const double*) tensorK->data;
+    double* out = tensorOut->dbl_data();
+
+    // correlation is convolution with reversed kernel
+    auto k_at = [=](size_t j) { return correlate ? kernel[m - 1 - j] : kernel[j]; };
+
+    if (std::min(n, m) <= DIRECT_MAX_KERNEL)
+    {
+        for (size_t i = 0; i < len; ++i) {
+            const size_t t = offset + i;
+            const size_t jmin = (t >= n)? t - n + 1 : 0;
+            const size_t jmax = std::min(t, m - 1);
+            double sum {0.0};
+            for (size_t j = jmin; j <= jmax; ++j) {
+                sum += x[t - j] * k_at(j);
+            }
+            out[i] = sum;
+        }
+        return nifOut;
+    }
+
+    const size_t L = good_fft_size(full);
+
+    FFTPlanCache& cache = FFTPlanCache::local();
+    FFTPlan& plan = cache.get(L);
+
+    if (!plan.real() or !plan.halfcomplex()) {
+        return enif_make_badarg(env);
+    }
+
+    cache.buf.assign(2 * L, 0.0);
+    double* a = cache.buf.data();
+    double* b = a + L;
+
+    std::memcpy(a, x, sizeof(double) * n);
+    for (size_t j = 0; j < m; ++j) b[j] = k_at(j);
+
+    int status = gsl_fft_real_transform(a, 1, L, plan.realWt, plan.realWs);
+    if (status == GSL_SUCCESS) status = gsl_fft_real_transform(b, 1, L, plan.realWt, plan.realWs);
+    if (status != GSL_SUCCESS) return make_error(env, status);
+
+    multiply_halfcomplex(a, b, L);
+
+    status = gsl_fft_halfcomplex_inverse(a, 1, L, plan.hcWt, plan.realWs);
+    if (status != GSL_SUCCESS) return make_error(env, status);
+
+    std::memcpy(out, a + offset, sizeof(double) * len);
+
+    return nifOut;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file
+ * @brief     FFT, convolution and correlation with GSL.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_gsl_fft_real(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_fft_real_inverse(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_fft_complex(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_convolve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -4,74 +4,319 @@
  *
  * A smoothing basis spline (B-spline) differs from an interpolating spline
  * in that the resulting curve is not required to pass through each datapoint.
- * 
+ *
  * B-splines are commonly used as basis functions to ﬁt smoothing curves to large data sets.
  * To do this, the abscissa axis is broken up into some number of intervals,
  * where the endpoints of each interval are called _breakpoints_.
  * These breakpoints are then converted to knots by imposing various continuity
- * and smoothness conditions at each interface. 
+ * and smoothness conditions at each interface.
+ *
+ * Solver is kept in Object NIF resource, B-spline and least squares
+ * workspaces are allocated once and reused by all fits with up to
+ * `nmax` data points, larger fit grows them. Only `order` basis
+ * functions are non-zero at any x, rows of design matrix and
+ * evaluation use gsl_bspline_eval_nonzero, O(order) per point.
  */
+#include "gsl/fit_bspline.hpp"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_bspline.h>
+#include <gsl/gsl_multifit.h>
+#include <gsl/gsl_statistics.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/object.hpp"
+#include "tensor/nif_resource.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
 
-struct BSplineSolver
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+struct BSplineSolver : public numy::Object
 {
+    static unsigned constexpr KIND = numy::Object::K_BSPLINE;
+
     // The computation of B-spline functions requires a preallocated workspace.
     gsl_bspline_workspace* wrkspace;
 
+    const size_t order;
+
     // Number of basis functions.
     const size_t ncoeffs;
 
     const size_t nbreak;
 
-    gsl_vector* B;   // splines
+    gsl_vector* Bk;  // non-zero splines at x
     gsl_vector* c;   // coeffs
     gsl_matrix* cov;
 
-    double chisq, Rsq, dof, tss;
+    // design matrix and fit workspace for up to nmax data points
+    size_t nmax {0};
+    gsl_matrix* X {nullptr};
+    gsl_multifit_linear_workspace* mw {nullptr};
+
+    double chisq {0.0}, Rsq {0.0}, dof {0.0}, tss {0.0};
+    bool fitted {false};
+
+    // fitted range, breakpoints are uniform over [xa, xb]
+    double xa {0.0}, xb {0.0};
 
-    BSplineSolver(size_t nbasis, size_t order = 4):
-        ncoeffs(nbasis), nbreak(ncoeffs + 2 - order)
+    ErlNifMutex* mutex;
+
+    BSplineSolver(size_t nbasis, size_t k = 4):
+        numy::Object(KIND), order(k), ncoeffs(nbasis), nbreak(ncoeffs + 2 - order)
     {
         wrkspace = gsl_bspline_alloc(order, nbreak);
-        B = gsl_vector_alloc(ncoeffs);
+        Bk = gsl_vector_alloc(order);
         c = gsl_vector_alloc(ncoeffs);
         cov = gsl_matrix_alloc(ncoeffs, ncoeffs);
+        mutex = enif_mutex_create((char*) "numy_bspline");
+    }
+
+   ~BSplineSolver() override {
+        if (mw != nullptr) gsl_multifit_linear_free(mw);
+        if (X != nullptr) gsl_matrix_free(X);
+        if (cov != nullptr) gsl_matrix_free(cov);
+        if (c != nullptr) gsl_vector_free(c);
+        if (Bk != nullptr) gsl_vector_free(Bk);
+        if (wrkspace != nullptr) gsl_bspline_free(wrkspace);
+        if (mutex != nullptr) enif_mutex_destroy(mutex);
     }
 
-   ~BSplineSolver() {
-        gsl_matrix_free(cov);
-        gsl_vector_free(c);
-        gsl_vector_free(B);
-        gsl_bspline_free(wrkspace);
+    bool isAllocated() const {
+        return wrkspace != nullptr and Bk != nullptr and c != nullptr and
+            cov != nullptr and mutex != nullptr;
     }
 
     int make_knots_uniform(const double a, const double b) {
-        return gsl_bspline_knots_uniform(a, b, wrkspace); 
+        xa = a; xb = b;
+        return gsl_bspline_knots_uniform(a, b, wrkspace);
     }
 
-    void fit(gsl_vector* x, gsl_vector* y, gsl_vector* w, size_t data_size) {
-        // ??? min/max? XXX make_knots_uniform(a, b);
-        gsl_matrix* X = gsl_matrix_alloc(data_size, ncoeffs);
-        make_fit_matrix(X, data_size);
-        gsl_multifit_linear_workspace* mw = gsl_multifit_linear_alloc(data_size, ncoeffs)
-        gsl_multifit_wlinear(X, w, y, c, cov, &chisq, mw);
-        gsl_multifit_linear_free(mw);
-        gsl_matrix_free(X);
+    /// Grow design matrix and fit workspace to hold data_size points.
+    bool reserve(size_t data_size) {
+        if (data_size <= nmax) return true;
 
-        dof = data_size - ncoeffs;
-        tss = gsl_stats_wtss(w->data, 1, y->data, 1, y->size);
-        Rsq = 1.0 - chisq / tss;
+        if (mw != nullptr) gsl_multifit_linear_free(mw);
+        if (X != nullptr) gsl_matrix_free(X);
+
+        X = gsl_matrix_alloc(data_size, ncoeffs);
+        mw = gsl_multifit_linear_alloc(data_size, ncoeffs);
+        nmax = (X != nullptr and mw != nullptr)? data_size : 0;
+
+        return nmax != 0;
     }
 
-    void make_fit_matrix(gsl_matrix* X, gsl_vector* x, size_t data_size) {
+    /// Fill rows of X with B_j(xᵢ), only `order` of them are non-zero.
+    int make_fit_matrix(gsl_matrix* A, const double* x, size_t data_size) {
         for (size_t i = 0; i < data_size; ++i) {
-            double xi = gsl_vector_get(x, i);
-            /* compute B_j(xi) for all j */
-            gsl_bspline_eval(xi, B, wrkspace);
-            /* fill in row i of X */
-            for (size_t j = 0; j < ncoeffs; ++j) {
-                double Bj = gsl_vector_get(B, j);
-                gsl_matrix_set(X, i, j, Bj);
+            double* row = A->data + i * A->tda;
+            std::fill(row, row + ncoeffs, 0.0);
+            size_t istart, iend;
+            int status = gsl_bspline_eval_nonzero(x[i], Bk, &istart, &iend, wrkspace);
+            if (status != GSL_SUCCESS) return status;
+            for (size_t j = istart; j <= iend; ++j) {
+                row[j] = Bk->data[(j - istart) * Bk->stride];
             }
         }
+        return GSL_SUCCESS;
+    }
+
+    /// Least squares fit, w may be nullptr for unweighted fit.
+    int fit(const double* x, const double* y, const double* w, size_t data_size) {
+        const auto [xmin, xmax] = std::minmax_element(x, x + data_size);
+
+        int status = make_knots_uniform(*xmin, *xmax);
+        if (status != GSL_SUCCESS) return status;
+
+        if (!reserve(data_size)) return GSL_ENOMEM;
+
+        gsl_matrix_view A = gsl_matrix_submatrix(X, 0, 0, data_size, ncoeffs);
+        status = make_fit_matrix(&A.matrix, x, data_size);
+        if (status != GSL_SUCCESS) return status;
+
+        gsl_vector_const_view vy = gsl_vector_const_view_array(y, data_size);
+
+        if (w != nullptr) {
+            gsl_vector_const_view vw = gsl_vector_const_view_array(w, data_size);
+            status = gsl_multifit_wlinear(&A.matrix, &vw.vector, &vy.vector, c, cov, &chisq, mw);
+            tss = gsl_stats_wtss(w, 1, y, 1, data_size);
+        }
+        else {
+            status = gsl_multifit_linear(&A.matrix, &vy.vector, c, cov, &chisq, mw);
+            tss = gsl_stats_tss(y, 1, data_size);
+        }
+        if (status != GSL_SUCCESS) return status;
+
+        dof = data_size - ncoeffs;
+        Rsq = 1.0 - chisq / tss;
+        fitted = true;
+
+        return GSL_SUCCESS;
+    }
+
+    /// Value of fitted curve at x, x must be inside of fitted range.
+    double eval(double x) {
+        size_t istart, iend;
+        if (gsl_bspline_eval_nonzero(x, Bk, &istart, &iend, wrkspace) != GSL_SUCCESS) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        double val {0.0};
+        for (size_t j = istart; j <= iend; ++j) {
+            val += Bk->data[(j - istart) * Bk->stride] * c->data[j * c->stride];
+        }
+        return val;
+    }
+
+    /// Value at x, outside of fitted range it is value at nearest end
+    /// when `clamp`, `fill` otherwise.
+    double eval(double x, bool clamp, double fill) {
+        if (x < xa or x > xb) {
+            if (!clamp) return fill;
+            x = std::clamp(x, xa, xb);
+        }
+        return eval(x);
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * Create B-spline solver.
+ *
+ * argv[0] - number of basis functions (coefficients)
+ * argv[1] - spline order, 4 for cubic
+ */
+NUMY_ERL_FUN numy_gsl_bspline_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    unsigned ncoeffs {0}, order {0};
+
+    if (argc != 2 or !enif_get_uint(env, argv[0], &ncoeffs) or
+        !enif_get_uint(env, argv[1], &order) or order < 1 or ncoeffs < order)
+    {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifSolver;
+    BSplineSolver* solver = numy::tnsr::newObject<BSplineSolver>(env, nifSolver, ncoeffs, order);
+
+    if (solver == nullptr or !solver->isAllocated()) {
+        return enif_make_badarg(env);
+    }
+
+    return nifSolver;
+}
+
+/**
+ * Fit smoothing B-spline, breakpoints are uniform over [min x, max x].
+ *
+ * argv[0] - solver
+ * argv[1] - x, tensor of n elements
+ * argv[2] - y, tensor of n elements
+ * argv[3] - weights, tensor of n elements or nil
+ *
+ * Returns {chisq, r2, dof} or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_bspline_fit(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 4) {
+        return enif_make_badarg(env);
+    }
+
+    BSplineSolver* solver = numy::tnsr::getObject<BSplineSolver>(env, argv[0]);
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[1]);
+    const numy::Tensor* tensorY = numy::tnsr::getTensor(env, argv[2]);
+
+    if (solver == nullptr or
+        tensorX == nullptr or !tensorX->isValid() or
+        tensorY == nullptr or !tensorY->isValid() or
+        tensorX->nrElements != tensorY->nrElements or
+        tensorX->nrElements < solver->ncoeffs)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const double* w = nullptr;
+    if (!enif_is_atom(env, argv[3])) {
+        const numy::Tensor* tensorW = numy::tnsr::getTensor(env, argv[3]);
+        if (tensorW == nullptr or !tensorW->isValid() or tensorW->nrElements != tensorX->nrElements) {
+            return enif_make_badarg(env);
+        }
+        w = (const double*) tensorW->data;
+    }
+
+    enif_mutex_lock(solver->mutex);
+    int status = solver->fit((const double*) tensorX->data, (const double*) tensorY->data,
+        w, tensorX->nrElements);
+    const double chisq = solver->chisq, rsq = solver->Rsq, dof = solver->dof;
+    enif_mutex_unlock(solver->mutex);
+
+    if (status != GSL_SUCCESS) {
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, status));
+    }
+
+    return enif_make_tuple3(env,
+        enif_make_double(env, chisq), enif_make_double(env, rsq), enif_make_double(env, dof));
+}
+
+/**
+ * Evaluate fitted B-spline.
+ *
+ * argv[0] - solver
+ * argv[1] - x, tensor of query points
+ * argv[2] - outside of fitted range: atom :clamp for value at nearest end,
+ *           or float fill value
+ *
+ * Returns new tensor of same shape as x.
+ */
+NUMY_ERL_FUN numy_gsl_bspline_eval(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    BSplineSolver* solver = numy::tnsr::getObject<BSplineSolver>(env, argv[0]);
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[1]);
+
+    double fill {0.0};
+    const bool clamp = !enif_get_double(env, argv[2], &fill);
+
+    if (solver == nullptr or tensorX == nullptr or !tensorX->isValid() or
+        (clamp and !enif_is_identical(argv[2], enif_make_atom(env, "clamp"))))
+    {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, tensorX->nrDims, tensorX->shape, nifOut);
+
+    if (tensorOut == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* x = (const double*) tensorX->data;
+    double* out = tensorOut->dbl_data();
+
+    enif_mutex_lock(solver->mutex);
+    const bool fitted = solver->fitted;
+    if (fitted) {
+        for (unsigned i = 0; i < tensorX->nrElements; ++i) {
+            out[i] = solver->eval(x[i], clamp, fill);
+        }
     }
-};
\ No newline at end of file
+    enif_mutex_unlock(solver->mutex);
+
+    if (!fitted) {
+        return enif_make_badarg(env);
+    }
+
+    return nifOut;
+}
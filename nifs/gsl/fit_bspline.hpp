@@ -0,0 +1,14 @@
+/**
+ * @file
+ * @brief     Fit B-Spline with GSL.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_gsl_bspline_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_bspline_fit(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_bspline_eval(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
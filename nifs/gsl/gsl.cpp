@@ -19,6 +19,11 @@
 #include "tensor/tensor.hpp"
 #include "tensor/nif_resource.hpp"
 
+/*
+ * GSL algorithms are built into Numy.Lapack library
+ * and take its tensors directly, see lapack.cpp.
+ */
+
 static ErlNifFunc nif_funcs[] = {
     {       "create_tensor",   1,      numy_tensor_create,   0}
 };
@@ -26,7 +31,7 @@ static ErlNifFunc nif_funcs[] = {
 // Performs all the magic needed to actually hook things up.
 //
 ERL_NIF_INIT(
-    Elixir.Numy.Sl,  // Erlang module where the NIFs we export will be defined
+    Elixir.Numy.SL,  // Erlang module where the NIFs we export will be defined
     nif_funcs,       // array of ErlNifFunc structs that defines which NIFs will be exported
     &numy_load_nif,
     &numy_reload_nif,
@@ -0,0 +1,206 @@
+/**
+ * @file
+ * @brief     1-D interpolation with GSL.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Interpolant (linear, cubic spline or Akima) is built once from
+ * knots x, y and kept in Object NIF resource, then evaluated at
+ * whole tensor of query points per call.
+ *
+ * When queries are sorted, evaluation walks the knots once
+ * and sets accelerator's cached interval before each
+ * gsl_spline_eval_e, so GSL never does binary search.
+ * Unsorted queries use the accelerator as usual.
+ *
+ * Queries outside of knots range take value at the nearest end
+ * (clamp) or given fill value.
+ *
+ * Built spline is never changed, each call has its own accelerator
+ * on stack, so concurrent evaluations need no lock.
+ */
+#include "gsl/interp.hpp"
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_interp.h>
+#include <gsl/gsl_spline.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/object.hpp"
+#include "tensor/nif_resource.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+struct Interpolant : public numy::Object
+{
+    static unsigned constexpr KIND = numy::Object::K_INTERP;
+
+    gsl_spline* spline;
+    const size_t size;
+
+    Interpolant(const gsl_interp_type* type, size_t n):
+        numy::Object(KIND), size(n)
+    {
+        spline = gsl_spline_alloc(type, n);
+    }
+
+    ~Interpolant() override {
+        if (spline != nullptr) gsl_spline_free(spline);
+    }
+
+    /// Out of knots range value is at nearest end when `clamp`, `fill` otherwise.
+    double eval(double x, gsl_interp_accel* acc, bool clamp, double fill) const {
+        const double xa = spline->x[0], xb = spline->x[size - 1];
+        if (x < xa or x > xb) {
+            if (!clamp) return fill;
+            x = std::clamp(x, xa, xb);
+        }
+        double y;
+        if (gsl_spline_eval_e(spline, x, acc, &y) != GSL_SUCCESS) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return y;
+    }
+
+    /// Evaluate at sorted queries walking knot intervals once.
+    void eval_sorted(const double* q, double* out, size_t nq, bool clamp, double fill) const {
+        const double* x = spline->x;
+        gsl_interp_accel acc {0, 0, 0};
+        size_t k = 0;
+        for (size_t i = 0; i < nq; ++i) {
+            while (k + 2 < size and x[k + 1] <= q[i]) ++k;
+            acc.cache = k;
+            out[i] = eval(q[i], &acc, clamp, fill);
+        }
+    }
+
+    void eval_unsorted(const double* q, double* out, size_t nq, bool clamp, double fill) const {
+        gsl_interp_accel acc {0, 0, 0};
+        for (size_t i = 0; i < nq; ++i) {
+            out[i] = eval(q[i], &acc, clamp, fill);
+        }
+    }
+};
+
+const gsl_interp_type* get_interp_type(ErlNifEnv* env, ERL_NIF_TERM term)
+{
+    char atom[16];
+    if (!enif_get_atom(env, term, atom, sizeof(atom), ERL_NIF_LATIN1)) {
+        return nullptr;
+    }
+
+    if (0 == strcmp(atom, "linear")) return gsl_interp_linear;
+    if (0 == strcmp(atom, "cspline")) return gsl_interp_cspline;
+    if (0 == strcmp(atom, "akima")) return gsl_interp_akima;
+
+    return nullptr;
+}
+
+} // anonymous namespace
+
+/**
+ * Build interpolant.
+ *
+ * argv[0] - x, tensor of strictly increasing knots
+ * argv[1] - y, tensor of values at knots
+ * argv[2] - type, atom :linear, :cspline or :akima
+ *
+ * Returns interpolant object or {:error, gsl_error_code}.
+ */
+NUMY_ERL_FUN numy_gsl_interp_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[0]);
+    const numy::Tensor* tensorY = numy::tnsr::getTensor(env, argv[1]);
+    const gsl_interp_type* type = get_interp_type(env, argv[2]);
+
+    if (tensorX == nullptr or !tensorX->isValid() or
+        tensorY == nullptr or !tensorY->isValid() or type == nullptr or
+        tensorX->nrElements != tensorY->nrElements or
+        tensorX->nrElements < gsl_interp_type_min_size(type))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n = tensorX->nrElements;
+
+    ERL_NIF_TERM nifInterp;
+    Interpolant* interp = numy::tnsr::newObject<Interpolant>(env, nifInterp, type, n);
+
+    if (interp == nullptr or interp->spline == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    int status = gsl_spline_init(interp->spline,
+        (const double*) tensorX->data, (const double*) tensorY->data, n);
+
+    if (status != GSL_SUCCESS) {
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, status));
+    }
+
+    return nifInterp;
+}
+
+/**
+ * Evaluate interpolant.
+ *
+ * argv[0] - interpolant
+ * argv[1] - x, tensor of query points
+ * argv[2] - outside of knots range: atom :clamp for value at nearest end,
+ *           or float fill value
+ *
+ * Returns new tensor of same shape as x.
+ */
+NUMY_ERL_FUN numy_gsl_interp_eval(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const Interpolant* interp = numy::tnsr::getObject<Interpolant>(env, argv[0]);
+    const numy::Tensor* tensorQ = numy::tnsr::getTensor(env, argv[1]);
+
+    double fill {0.0};
+    const bool clamp = !enif_get_double(env, argv[2], &fill);
+
+    if (interp == nullptr or tensorQ == nullptr or !tensorQ->isValid() or
+        (clamp and !enif_is_identical(argv[2], enif_make_atom(env, "clamp"))))
+    {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, tensorQ->nrDims, tensorQ->shape, nifOut);
+
+    if (tensorOut == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* q = (const double*) tensorQ->data;
+    const size_t nq = tensorQ->nrElements;
+
+    bool sorted = true;
+    for (size_t i = 1; i < nq and sorted; ++i) {
+        sorted = (q[i - 1] <= q[i]);
+    }
+
+    if (sorted) {
+        interp->eval_sorted(q, tensorOut->dbl_data(), nq, clamp, fill);
+    }
+    else {
+        interp->eval_unsorted(q, tensorOut->dbl_data(), nq, clamp, fill);
+    }
+
+    return nifOut;
+}
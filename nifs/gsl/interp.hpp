@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief     1-D interpolation with GSL.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_gsl_interp_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_gsl_interp_eval(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -34,6 +34,36 @@ NUMY_ERL_FUN numy_blas_drotg(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]
 }
 
 
+/**
+ * Get BLAS vector argument: tensor and increment, check that `n` elements
+ * with the increment fit into the tensor, 1 + (n-1)*|inc| <= nrElements.
+ */
+static
+bool get_blas_vector(ErlNifEnv* env, ERL_NIF_TERM tensorTerm, ERL_NIF_TERM incTerm,
+    int n, double*& x, int& inc, bool allowNegativeInc = true)
+{
+    numy::Tensor* tensor = numy::tnsr::getTensor(env, tensorTerm);
+
+    if (tensor == nullptr or !tensor->isValid() or
+        !enif_get_int(env, incTerm, &inc) or inc == 0 or
+        (inc < 0 and !allowNegativeInc))
+    {
+        return false;
+    }
+
+    x = tensor->dbl_data();
+
+    const int64_t absInc = (inc < 0)? -inc : inc;
+
+    return n == 0 or (1 + (int64_t)(n - 1) * absInc) <= (int64_t) tensor->nrElements;
+}
+
+static inline
+bool get_blas_n(ErlNifEnv* env, ERL_NIF_TERM term, int& n)
+{
+    return enif_get_int(env, term, &n) and n >= 0;
+}
+
 //http://www.netlib.org/lapack/explore-html/df/d28/group__single__blas__level1_ga24785e467bd921df5a2b7300da57c469.html#ga24785e467bd921df5a2b7300da57c469
 //DCOPY copies a vector, x, to a vector, y.
 // [in]  num    - number of elements in input vector(s)
@@ -42,23 +72,346 @@ NUMY_ERL_FUN numy_blas_drotg(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]
 // [out] dst    - dst vector, dimension ( 1 + ( N - 1 )*abs( INCY ) )
 // [in]  dstInc - storage spacing between elements dst
 //
-NUMY_ERL_FUN numy_blas_dcopy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[] UNUSED)
+NUMY_ERL_FUN numy_blas_dcopy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-    if (argc != 5) {
+    int n, incx, incy;
+    double *x, *y;
+
+    if (argc != 5 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx) or
+        !get_blas_vector(env, argv[3], argv[4], n, y, incy))
+    {
         return enif_make_badarg(env);
     }
 
-    // XXX TODO XXX
+    cblas_dcopy(n, x, incx, y, incy);
 
     return numy::tnsr::getOkAtom(env);
 }
 
 // Scale: 𝑥 ← 𝛼𝑥
+// [in]     n, alpha
+// [in,out] x, incx
+//
+NUMY_ERL_FUN numy_blas_dscal(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx;
+    double alpha, *x;
+
+    if (argc != 4 or !get_blas_n(env, argv[0], n) or
+        !numy::tnsr::getNumber(env, argv[1], alpha) or
+        !get_blas_vector(env, argv[2], argv[3], n, x, incx, false))
+    {
+        return enif_make_badarg(env);
+    }
+
+    cblas_dscal(n, alpha, x, incx);
+
+    return numy::tnsr::getOkAtom(env);
+}
 
 // axpy: 𝑦 ← 𝛼𝑥 + 𝑦
+// [in]     n, alpha, x, incx
+// [in,out] y, incy
+//
+NUMY_ERL_FUN numy_blas_daxpy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx, incy;
+    double alpha, *x, *y;
+
+    if (argc != 6 or !get_blas_n(env, argv[0], n) or
+        !numy::tnsr::getNumber(env, argv[1], alpha) or
+        !get_blas_vector(env, argv[2], argv[3], n, x, incx) or
+        !get_blas_vector(env, argv[4], argv[5], n, y, incy))
+    {
+        return enif_make_badarg(env);
+    }
+
+    cblas_daxpy(n, alpha, x, incx, y, incy);
+
+    return numy::tnsr::getOkAtom(env);
+}
 
 // dot: dot ← 𝑥ᵀ𝑦
+// [in] n, x, incx, y, incy
+//
+NUMY_ERL_FUN numy_blas_ddot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx, incy;
+    double *x, *y;
 
-// __dot: dot ← 𝛼 + 𝑥ᵀ𝑦
+    if (argc != 5 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx) or
+        !get_blas_vector(env, argv[3], argv[4], n, y, incy))
+    {
+        return enif_make_badarg(env);
+    }
 
-// nrm2
+    return enif_make_double(env, cblas_ddot(n, x, incx, y, incy));
+}
+
+// nrm2: ‖𝑥‖₂ = √∑𝑥ᵢ²
+// [in] n, x, incx
+//
+NUMY_ERL_FUN numy_blas_dnrm2(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx;
+    double *x;
+
+    if (argc != 3 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx, false))
+    {
+        return enif_make_badarg(env);
+    }
+
+    return enif_make_double(env, cblas_dnrm2(n, x, incx));
+}
+
+// asum: ∑|𝑥ᵢ|
+// [in] n, x, incx
+//
+NUMY_ERL_FUN numy_blas_dasum(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx;
+    double *x;
+
+    if (argc != 3 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx, false))
+    {
+        return enif_make_badarg(env);
+    }
+
+    return enif_make_double(env, cblas_dasum(n, x, incx));
+}
+
+// amax: index of first element with max |𝑥ᵢ|, 0-based, -1 if n is 0
+// [in] n, x, incx
+//
+NUMY_ERL_FUN numy_blas_idamax(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx;
+    double *x;
+
+    if (argc != 3 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx, false))
+    {
+        return enif_make_badarg(env);
+    }
+
+    if (n == 0) {
+        return enif_make_int(env, -1);
+    }
+
+    return enif_make_int(env, (int) cblas_idamax(n, x, incx));
+}
+
+// rot: apply plane rotation,
+//   𝑥ᵢ ← c𝑥ᵢ + s𝑦ᵢ
+//   𝑦ᵢ ← c𝑦ᵢ - s𝑥ᵢ
+// [in]     n, c, s
+// [in,out] x, incx, y, incy
+//
+NUMY_ERL_FUN numy_blas_drot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx, incy;
+    double c, s, *x, *y;
+
+    if (argc != 7 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx) or
+        !get_blas_vector(env, argv[3], argv[4], n, y, incy) or
+        !numy::tnsr::getNumber(env, argv[5], c) or !numy::tnsr::getNumber(env, argv[6], s))
+    {
+        return enif_make_badarg(env);
+    }
+
+    cblas_drot(n, x, incx, y, incy, c, s);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+// rotm: apply modified plane rotation H,
+// param = [flag, h11, h21, h12, h22], see drotmg.
+// [in]     n, param
+// [in,out] x, incx, y, incy
+//
+NUMY_ERL_FUN numy_blas_drotm(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    int n, incx, incy;
+    double *x, *y;
+
+    if (argc != 6 or !get_blas_n(env, argv[0], n) or
+        !get_blas_vector(env, argv[1], argv[2], n, x, incx) or
+        !get_blas_vector(env, argv[3], argv[4], n, y, incy))
+    {
+        return enif_make_badarg(env);
+    }
+
+    double param[5];
+    unsigned len {0};
+    ERL_NIF_TERM head, tail = argv[5];
+
+    if (!enif_get_list_length(env, tail, &len) or len != 5) {
+        return enif_make_badarg(env);
+    }
+
+    for (unsigned i = 0; i < 5; ++i) {
+        if (!enif_get_list_cell(env, tail, &head, &tail) or
+            !numy::tnsr::getNumber(env, head, param[i]))
+        {
+            return enif_make_badarg(env);
+        }
+    }
+
+    cblas_drotm(n, x, incx, y, incy, param);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+static inline
+bool get_transpose(ErlNifEnv* env, ERL_NIF_TERM term, CBLAS_TRANSPOSE& trans)
+{
+    if (enif_is_identical(term, numy::tnsr::getTrueAtom(env))) {
+        trans = CblasTrans;
+        return true;
+    }
+    if (enif_is_identical(term, numy::tnsr::getFalseAtom(env))) {
+        trans = CblasNoTrans;
+        return true;
+    }
+    return false;
+}
+
+static inline
+bool get_matrix(ErlNifEnv* env, ERL_NIF_TERM term, numy::Tensor*& tensor)
+{
+    tensor = numy::tnsr::getTensor(env, term);
+    return tensor != nullptr and tensor->isValid() and tensor->nrDims <= 2;
+}
+
+/**
+ * Get output tensor argument, allocate new one of shape [cols, rows]
+ * (or [rows] when cols is 0) if the argument is `nil`.
+ */
+static
+bool get_output(ErlNifEnv* env, ERL_NIF_TERM term, unsigned rows, unsigned cols,
+    numy::Tensor*& tensor, ERL_NIF_TERM& outTerm, bool& isNew)
+{
+    ERL_NIF_TERM nilAtom = enif_make_atom(env, "nil");
+
+    isNew = enif_is_identical(term, nilAtom);
+
+    if (isNew) {
+        unsigned shape[2] = {cols, rows};
+        tensor = (cols == 0)?
+            numy::tnsr::newTensor(env, 1, &shape[1], outTerm):
+            numy::tnsr::newTensor(env, 2, shape, outTerm);
+        return tensor != nullptr;
+    }
+
+    outTerm = term;
+    tensor = numy::tnsr::getTensor(env, term);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+        return false;
+    }
+
+    return (cols == 0)?
+        tensor->nrElements == rows :
+        tensor->nrDims <= 2 and tensor->nr_rows() == rows and tensor->nr_cols() == cols;
+}
+
+// gemv: 𝑦 ← 𝛼op(𝐴)𝑥 + 𝛽𝑦, op(𝐴) is 𝐴 or 𝐴ᵀ
+// [in]     trans - true to use 𝐴ᵀ
+// [in]     alpha, a, x, beta
+// [in,out] y - vector or nil to allocate new one (then beta is ignored)
+//
+// Returns y.
+//
+NUMY_ERL_FUN numy_blas_dgemv(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    CBLAS_TRANSPOSE trans;
+    double alpha, beta;
+    numy::Tensor *a, *x, *y;
+
+    if (argc != 6 or !get_transpose(env, argv[0], trans) or
+        !numy::tnsr::getNumber(env, argv[1], alpha) or
+        !get_matrix(env, argv[2], a) or
+        (x = numy::tnsr::getTensor(env, argv[3])) == nullptr or !x->isValid() or
+        !numy::tnsr::getNumber(env, argv[4], beta))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned m = a->nr_rows(), n = a->nr_cols();
+    const unsigned xLen = (trans == CblasNoTrans)? n : m;
+    const unsigned yLen = (trans == CblasNoTrans)? m : n;
+
+    if (x->nrElements != xLen) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM yTerm;
+    bool isNew {false};
+
+    if (!get_output(env, argv[5], yLen, 0, y, yTerm, isNew) or
+        y->overlaps(*x) or y->overlaps(*a))
+    {
+        return enif_make_badarg(env);
+    }
+
+    cblas_dgemv(CblasRowMajor, trans, m, n,
+        alpha, a->dbl_data(), n,
+        x->dbl_data(), 1,
+        isNew? 0.0 : beta, y->dbl_data(), 1);
+
+    return yTerm;
+}
+
+// gemm: 𝐶 ← 𝛼op(𝐴)op(𝐵) + 𝛽𝐶, op(𝑋) is 𝑋 or 𝑋ᵀ
+// [in]     transA, transB - true to use transposed matrix
+// [in]     alpha, a, b, beta
+// [in,out] c - matrix or nil to allocate new one (then beta is ignored)
+//
+// Returns c.
+//
+NUMY_ERL_FUN numy_blas_dgemm(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    CBLAS_TRANSPOSE transA, transB;
+    double alpha, beta;
+    numy::Tensor *a, *b, *c;
+
+    if (argc != 7 or !get_transpose(env, argv[0], transA) or
+        !get_transpose(env, argv[1], transB) or
+        !numy::tnsr::getNumber(env, argv[2], alpha) or
+        !get_matrix(env, argv[3], a) or
+        !get_matrix(env, argv[4], b) or
+        !numy::tnsr::getNumber(env, argv[5], beta))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned m  = (transA == CblasNoTrans)? a->nr_rows() : a->nr_cols();
+    const unsigned k  = (transA == CblasNoTrans)? a->nr_cols() : a->nr_rows();
+    const unsigned kb = (transB == CblasNoTrans)? b->nr_rows() : b->nr_cols();
+    const unsigned n  = (transB == CblasNoTrans)? b->nr_cols() : b->nr_rows();
+
+    if (k != kb) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM cTerm;
+    bool isNew {false};
+
+    if (!get_output(env, argv[6], m, n, c, cTerm, isNew) or
+        c->overlaps(*a) or c->overlaps(*b))
+    {
+        return enif_make_badarg(env);
+    }
+
+    cblas_dgemm(CblasRowMajor, transA, transB, m, n, k,
+        alpha, a->dbl_data(), a->nr_cols(),
+        b->dbl_data(), b->nr_cols(),
+        isNew? 0.0 : beta, c->dbl_data(), n);
+
+    return cTerm;
+}
@@ -10,4 +10,14 @@
 #include <erl_nif.h>
 
 ERL_NIF_TERM numy_blas_drotg(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
-ERL_NIF_TERM numy_blas_dcopy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
\ No newline at end of file
+ERL_NIF_TERM numy_blas_dcopy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_dscal(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_daxpy(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_ddot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_dnrm2(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_dasum(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_idamax(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_drot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_drotm(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_dgemv(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_blas_dgemm(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
\ No newline at end of file
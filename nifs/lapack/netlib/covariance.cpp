@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief     Covariance and correlation matrix.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Rows of X are observations, columns are variables.
+ * One pass computes column means, second pass copies X centered,
+ * then C = XcᵀXc/(n-1) is one cblas_dsyrk, which is cache-blocked
+ * and multithreaded in optimized BLAS. dsyrk computes only upper
+ * triangle, it is mirrored to lower. Correlation scales C by
+ * 1/σᵢσⱼ.
+ */
+#include "lapack/netlib/covariance.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include <cblas.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+/**
+ * Covariance or correlation matrix of columns.
+ *
+ * argv[0] - X, 2-D tensor [p, n], n observations of p variables, not changed
+ * argv[1] - true for correlation, false for covariance
+ *
+ * Returns new tensor [p, p].
+ */
+NUMY_ERL_FUN numy_lapack_covariance(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorX == nullptr or !tensorX->isValid() or tensorX->nrDims != 2 or
+        tensorX->nr_rows() < 2)
+    {
+        return enif_make_badarg(env);
+    }
+
+    bool correlation {false};
+    if (enif_is_identical(argv[1], numy::tnsr::getTrueAtom(env))) {
+        correlation = true;
+    }
+    else if (!enif_is_identical(argv[1], numy::tnsr::getFalseAtom(env))) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n = tensorX->nr_rows();
+    const size_t p = tensorX->nr_cols();
+    const double* x = (const double*) tensorX->data;
+
+    ERL_NIF_TERM nifC;
+    const unsigned shapeC[2] = {(unsigned) p, (unsigned) p};
+    numy::Tensor* tensorC = numy::tnsr::newTensor(env, 2, shapeC, nifC);
+
+    if (tensorC == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    double* c = tensorC->dbl_data();
+
+    // column means, walk rows to keep access contiguous
+    std::vector<double> mean(p, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = x + i * p;
+        for (size_t j = 0; j < p; ++j) {
+            mean[j] += row[j];
+        }
+    }
+    for (size_t j = 0; j < p; ++j) {
+        mean[j] /= n;
+    }
+
+    std::vector<double> xc(n * p);
+    for (size_t i = 0; i < n; ++i) {
+        const double* row = x + i * p;
+        double* rowc = xc.data() + i * p;
+        for (size_t j = 0; j < p; ++j) {
+            rowc[j] = row[j] - mean[j];
+        }
+    }
+
+    cblas_dsyrk(CblasRowMajor, CblasUpper, CblasTrans, p, n,
+        1.0 / (n - 1), xc.data(), p, 0.0, c, p);
+
+    if (correlation) {
+        // reuse mean as 1/σ
+        for (size_t j = 0; j < p; ++j) {
+            mean[j] = (c[j * p + j] > 0.0)? 1.0 / std::sqrt(c[j * p + j]) : 0.0;
+        }
+        for (size_t i = 0; i < p; ++i) {
+            for (size_t j = i; j < p; ++j) {
+                c[i * p + j] *= mean[i] * mean[j];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < p; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            c[i * p + j] = c[j * p + i];
+        }
+    }
+
+    return nifC;
+}
@@ -0,0 +1,359 @@
+/**
+ * @file
+ * @brief     Eigen decomposition and SVD.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * - symmetric eigen decomposition, all eigenpairs with dsyevd,
+ *   subset by index with dsyevr
+ * - thin SVD with dgesdd
+ * - truncated randomized SVD (Halko, Martinsson, Tropp), A×Ω sketch,
+ *   power iterations with QR re-orthonormalization, then small dgesdd
+ *
+ * Input A is never changed, results are new tensors.
+ *
+ * Row-major m×n A is column-major Aᵀ. SVD of Aᵀ = U'SV'ᵀ gives
+ * A = V'SU'ᵀ, column-major V'ᵀ buffer is row-major U of A and
+ * column-major U' buffer is row-major Vᵀ of A, so dgesdd writes
+ * results straight into output tensors without transposes.
+ */
+#include "lapack/netlib/decomposition.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <cblas.h>
+#include <lapacke.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "lapack/netlib/workspace.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+/**
+ * Thin SVD of row-major m×n A, A is destroyed.
+ * U is row-major m×k, Vᵀ is row-major k×n, k = min(m, n).
+ */
+lapack_int svd_row_major(lapack_int m, lapack_int n, double* a,
+    double* s, double* u, double* vt)
+{
+    const lapack_int k = std::min(m, n);
+
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    lapack_int* iwork = ws.iwork(8 * k);
+
+    lapack_int lwork = ws.lwork(numy::lapack::R_DGESDD, m, n, 0, [&](double* lworkOpt) {
+        return LAPACKE_dgesdd_work(LAPACK_COL_MAJOR, 'S', n, m, a, n,
+            s, vt, n, u, k, lworkOpt, -1, iwork);
+    });
+    if (lwork < 0) return lwork;
+
+    return LAPACKE_dgesdd_work(LAPACK_COL_MAJOR, 'S', n, m, a, n,
+        s, vt, n, u, k, ws.work(lwork), lwork, iwork);
+}
+
+/**
+ * Replace column-major rows×cols Y with orthonormal basis Q of its columns.
+ */
+lapack_int orthonormalize(double* y, lapack_int rows, lapack_int cols, double* tau)
+{
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    lapack_int lwork = ws.lwork(numy::lapack::R_DGEQRF, rows, cols, 0, [&](double* lworkOpt) {
+        return LAPACKE_dgeqrf_work(LAPACK_COL_MAJOR, rows, cols, y, rows, tau, lworkOpt, -1);
+    });
+    if (lwork < 0) return lwork;
+
+    lapack_int info = LAPACKE_dgeqrf_work(LAPACK_COL_MAJOR, rows, cols, y, rows, tau,
+        ws.work(lwork), lwork);
+    if (info != 0) return info;
+
+    lwork = ws.lwork(numy::lapack::R_DORGQR, rows, cols, 0, [&](double* lworkOpt) {
+        return LAPACKE_dorgqr_work(LAPACK_COL_MAJOR, rows, cols, cols, y, rows, tau, lworkOpt, -1);
+    });
+    if (lwork < 0) return lwork;
+
+    return LAPACKE_dorgqr_work(LAPACK_COL_MAJOR, rows, cols, cols, y, rows, tau,
+        ws.work(lwork), lwork);
+}
+
+ERL_NIF_TERM make_error(ErlNifEnv* env, lapack_int info)
+{
+    return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, info));
+}
+
+} // anonymous namespace
+
+/**
+ * Eigenvalues and eigenvectors of symmetric matrix.
+ *
+ * argv[0] - A, symmetric n×n 2-D tensor, not changed
+ * argv[1] - nil for all eigenpairs or tuple {first, last},
+ *           0-based inclusive indexes of eigenvalues in ascending order
+ *
+ * Returns {w, v}, w - eigenvalues in ascending order, tensor [k],
+ * v - eigenvectors as columns of n×k matrix, tensor [k, n];
+ * or {:error, info} when LAPACK fails.
+ */
+NUMY_ERL_FUN numy_lapack_eigh(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorA = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorA == nullptr or !tensorA->isValid() or tensorA->nrDims != 2 or
+        tensorA->nr_rows() != tensorA->nr_cols())
+    {
+        return enif_make_badarg(env);
+    }
+
+    const lapack_int n = tensorA->nr_cols();
+
+    int first {0}, last {n - 1};
+    const bool all = enif_is_atom(env, argv[1]);
+
+    if (!all) {
+        int arity {0};
+        const ERL_NIF_TERM* range {nullptr};
+        if (!enif_get_tuple(env, argv[1], &arity, &range) or arity != 2 or
+            !enif_get_int(env, range[0], &first) or !enif_get_int(env, range[1], &last) or
+            first < 0 or last < first or last >= n)
+        {
+            return enif_make_badarg(env);
+        }
+    }
+
+    const lapack_int k = last - first + 1;
+
+    ERL_NIF_TERM nifW, nifV;
+    const unsigned shapeW[1] = {(unsigned) k};
+    const unsigned shapeV[2] = {(unsigned) k, (unsigned) n};
+    numy::Tensor* tensorW = numy::tnsr::newTensor(env, 1, shapeW, nifW);
+    if (tensorW == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* tensorV = numy::tnsr::newTensor(env, 2, shapeV, nifV);
+    if (tensorV == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    // symmetric A is the same in both layouts, on exit
+    // dsyevd has eigenvectors in A, dsyevr in separate Z
+    double* a = ws.scratch(n * n + (all ? 0 : n * k));
+    double* z = a + n * n;
+    std::memcpy(a, tensorA->data, sizeof(double) * n * n);
+
+    double* w = tensorW->dbl_data();
+    lapack_int lwork {0}, liwork {0}, info {0};
+
+    if (all) {
+        info = ws.lworks(numy::lapack::R_DSYEVD, n, 0, 0, lwork, liwork,
+            [&](double* lworkOpt, lapack_int* liworkOpt) {
+                return LAPACKE_dsyevd_work(LAPACK_COL_MAJOR, 'V', 'L', n, a, n, w,
+                    lworkOpt, -1, liworkOpt, -1);
+            });
+        if (info != 0) return make_error(env, info);
+
+        info = LAPACKE_dsyevd_work(LAPACK_COL_MAJOR, 'V', 'L', n, a, n, w,
+            ws.work(lwork), lwork, ws.iwork(liwork), liwork);
+        if (info != 0) return make_error(env, info);
+
+        numy::lapack::to_row_major(a, n, n, n, tensorV->dbl_data());
+    }
+    else {
+        lapack_int found {0};
+
+        info = ws.lworks(numy::lapack::R_DSYEVR, n, 0, 0, lwork, liwork,
+            [&](double* lworkOpt, lapack_int* liworkOpt) {
+                return LAPACKE_dsyevr_work(LAPACK_COL_MAJOR, 'V', 'I', 'L', n, a, n,
+                    0.0, 0.0, first + 1, last + 1, 0.0, &found, w, z, n, nullptr,
+                    lworkOpt, -1, liworkOpt, -1);
+            });
+        if (info != 0) return make_error(env, info);
+
+        // ISUPPZ goes after integer work
+        lapack_int* iwork = ws.iwork(liwork + 2 * k);
+        info = LAPACKE_dsyevr_work(LAPACK_COL_MAJOR, 'V', 'I', 'L', n, a, n,
+            0.0, 0.0, first + 1, last + 1, 0.0, &found, w, z, n, iwork + liwork,
+            ws.work(lwork), lwork, iwork, liwork);
+        if (info != 0) return make_error(env, info);
+
+        numy::lapack::to_row_major(z, n, k, n, tensorV->dbl_data());
+    }
+
+    return enif_make_tuple2(env, nifW, nifV);
+}
+
+/**
+ * Thin singular value decomposition A = U×S×Vᵀ.
+ *
+ * argv[0] - A, m×n 2-D tensor, not changed
+ *
+ * Returns {u, s, vt}, k = min(m, n), u - tensor [k, m],
+ * s - singular values in descending order, tensor [k], vt - tensor [n, k];
+ * or {:error, info} when LAPACK fails.
+ */
+NUMY_ERL_FUN numy_lapack_svd(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorA = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorA == nullptr or !tensorA->isValid() or tensorA->nrDims != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const lapack_int m = tensorA->nr_rows();
+    const lapack_int n = tensorA->nr_cols();
+    const lapack_int k = std::min(m, n);
+
+    ERL_NIF_TERM nifU, nifS, nifVt;
+    const unsigned shapeU[2]  = {(unsigned) k, (unsigned) m};
+    const unsigned shapeS[1]  = {(unsigned) k};
+    const unsigned shapeVt[2] = {(unsigned) n, (unsigned) k};
+    numy::Tensor* tensorU  = numy::tnsr::newTensor(env, 2, shapeU, nifU);
+    if (tensorU == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* tensorS  = numy::tnsr::newTensor(env, 1, shapeS, nifS);
+    if (tensorS == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* tensorVt = numy::tnsr::newTensor(env, 2, shapeVt, nifVt);
+    if (tensorVt == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    double* a = numy::lapack::Workspace::local().scratch(m * n);
+    std::memcpy(a, tensorA->data, sizeof(double) * m * n);
+
+    lapack_int info = svd_row_major(m, n, a,
+        tensorS->dbl_data(), tensorU->dbl_data(), tensorVt->dbl_data());
+
+    if (info != 0) {
+        return make_error(env, info);
+    }
+
+    return enif_make_tuple3(env, nifU, nifS, nifVt);
+}
+
+/**
+ * Truncated randomized SVD, rank k approximation of A.
+ *
+ * argv[0] - A, m×n 2-D tensor, not changed
+ * argv[1] - k, number of singular triplets, k <= min(m, n)
+ * argv[2] - oversampling, extra sketch columns, typically 5..10
+ * argv[3] - number of power iterations, 1..2 for slowly decaying spectrum
+ * argv[4] - seed of random sketch
+ *
+ * Returns {u, s, vt} with u - tensor [k, m], s - tensor [k], vt - tensor [n, k];
+ * or {:error, info} when LAPACK fails.
+ */
+NUMY_ERL_FUN numy_lapack_rsvd(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 5) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorA = numy::tnsr::getTensor(env, argv[0]);
+
+    int k {0}, oversample {0}, powerIters {0};
+    unsigned long seed {0};
+
+    if (tensorA == nullptr or !tensorA->isValid() or tensorA->nrDims != 2 or
+        !enif_get_int(env, argv[1], &k) or !enif_get_int(env, argv[2], &oversample) or
+        !enif_get_int(env, argv[3], &powerIters) or !enif_get_ulong(env, argv[4], &seed) or
+        oversample < 0 or powerIters < 0)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const lapack_int m = tensorA->nr_rows();
+    const lapack_int n = tensorA->nr_cols();
+
+    if (k < 1 or k > std::min(m, n)) {
+        return enif_make_badarg(env);
+    }
+
+    // sketch size
+    const lapack_int l = std::min(k + oversample, std::min(m, n));
+
+    ERL_NIF_TERM nifU, nifS, nifVt;
+    const unsigned shapeU[2]  = {(unsigned) k, (unsigned) m};
+    const unsigned shapeS[1]  = {(unsigned) k};
+    const unsigned shapeVt[2] = {(unsigned) n, (unsigned) k};
+    numy::Tensor* tensorU  = numy::tnsr::newTensor(env, 2, shapeU, nifU);
+    if (tensorU == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* tensorS  = numy::tnsr::newTensor(env, 1, shapeS, nifS);
+    if (tensorS == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* tensorVt = numy::tnsr::newTensor(env, 2, shapeVt, nifVt);
+    if (tensorVt == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* a = (const double*) tensorA->data;
+
+    // Ω, Y and Z are column-major, row-major A is passed as column-major Aᵀ
+    std::vector<double> omega(n * l), y(m * l), z(n * l), tau(l);
+
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (double& x : omega) x = normal(rng);
+
+    // Y = A×Ω
+    cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, m, l, n,
+        1.0, a, n, omega.data(), n, 0.0, y.data(), m);
+
+    lapack_int info = orthonormalize(y.data(), m, l, tau.data());
+    if (info != 0) return make_error(env, info);
+
+    for (int i = 0; i < powerIters; ++i)
+    {
+        // Z = Aᵀ×Q, Y = A×Z
+        cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, n, l, m,
+            1.0, a, n, y.data(), m, 0.0, z.data(), n);
+        info = orthonormalize(z.data(), n, l, tau.data());
+        if (info != 0) return make_error(env, info);
+
+        cblas_dgemm(CblasColMajor, CblasTrans, CblasNoTrans, m, l, n,
+            1.0, a, n, z.data(), n, 0.0, y.data(), m);
+        info = orthonormalize(y.data(), m, l, tau.data());
+        if (info != 0) return make_error(env, info);
+    }
+
+    // B = Qᵀ×A, column-major Bᵀ = Aᵀ×Q is row-major l×n B
+    cblas_dgemm(CblasColMajor, CblasNoTrans, CblasNoTrans, n, l, m,
+        1.0, a, n, y.data(), m, 0.0, z.data(), n);
+
+    std::vector<double> ub(l * l), sb(l), vtb(l * n);
+
+    info = svd_row_major(l, n, z.data(), sb.data(), ub.data(), vtb.data());
+    if (info != 0) return make_error(env, info);
+
+    // U = Q×Ub[:, 0:k]
+    cblas_dgemm(CblasRowMajor, CblasTrans, CblasNoTrans, m, k, l,
+        1.0, y.data(), m, ub.data(), l, 0.0, tensorU->dbl_data(), k);
+
+    std::memcpy(tensorS->data, sb.data(), sizeof(double) * k);
+    std::memcpy(tensorVt->data, vtb.data(), sizeof(double) * k * n);
+
+    return enif_make_tuple3(env, nifU, nifS, nifVt);
+}
@@ -0,0 +1,14 @@
+/**
+ * @file
+ * @brief     Eigen decomposition and SVD.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_lapack_eigh(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_lapack_svd(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_lapack_rsvd(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -0,0 +1,243 @@
+/**
+ * @file
+ * @brief     Reusable LU, QR and Cholesky factorizations.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Factorization of A costs O(n³) (O(mn²) for QR), solving with
+ * already factored A is O(n²) per right hand side. Factorization
+ * is kept in Object NIF resource, so it is computed once and used
+ * for many solves. Caller's A is copied and never changed.
+ *
+ * - LU, dgetrf/dgetrs, square A
+ * - QR, dgeqrf then dormqr+dtrtrs, A is m×n with m >= n, least squares
+ * - Cholesky, dpotrf/dpotrs, symmetric positive definite A
+ *
+ * Routines are called through column-major LAPACKE_xxx_work with
+ * workspace from the per-thread cache. Row-major A is column-major Aᵀ:
+ * LU factors Aᵀ and solves with TRANS='T', upper Cholesky factor of
+ * row-major A is the lower factor of column-major A. Only QR needs
+ * a real column-major copy of A.
+ */
+#include "lapack/netlib/factorization.hpp"
+
+#include <cstring>
+
+#include <lapacke.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/object.hpp"
+#include "tensor/nif_resource.hpp"
+#include "lapack/netlib/workspace.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+struct Factorization : public numy::Object
+{
+    static unsigned constexpr KIND = numy::Object::K_FACTORIZATION;
+
+    enum Method {LU, QR, CHOLESKY};
+
+    const Method method;
+    const lapack_int m, n; ///< rows and columns of A
+
+    double*     a    = nullptr; ///< factored A, column-major for QR
+    double*     tau  = nullptr; ///< QR elementary reflectors
+    lapack_int* ipiv = nullptr; ///< LU pivots
+
+    Factorization(Method meth, lapack_int rows, lapack_int cols):
+        numy::Object(KIND), method(meth), m(rows), n(cols)
+    {
+        a = (double*) enif_alloc(sizeof(double) * m * n);
+        if (method == QR) {
+            tau = (double*) enif_alloc(sizeof(double) * n);
+        }
+        else if (method == LU) {
+            ipiv = (lapack_int*) enif_alloc(sizeof(lapack_int) * n);
+        }
+    }
+
+    ~Factorization() override {
+        if (ipiv != nullptr) enif_free(ipiv);
+        if (tau != nullptr) enif_free(tau);
+        if (a != nullptr) enif_free(a);
+    }
+
+    bool isAllocated() const {
+        return a != nullptr and
+            (method != QR or tau != nullptr) and
+            (method != LU or ipiv != nullptr);
+    }
+
+    /// Copy row-major A to storage layout used by the method.
+    void load(const double* src) {
+        if (method == QR) {
+            numy::lapack::to_col_major(src, m, n, a, m);
+        }
+        else {
+            std::memcpy(a, src, sizeof(double) * m * n);
+        }
+    }
+
+    lapack_int factorize() {
+        switch (method) {
+        case LU:
+            return LAPACKE_dgetrf_work(LAPACK_COL_MAJOR, n, n, a, n, ipiv);
+        case QR: {
+            numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+            lapack_int lwork = ws.lwork(numy::lapack::R_DGEQRF, m, n, 0, [&](double* lworkOpt) {
+                return LAPACKE_dgeqrf_work(LAPACK_COL_MAJOR, m, n, a, m, tau, lworkOpt, -1);
+            });
+            if (lwork < 0) return lwork;
+            return LAPACKE_dgeqrf_work(LAPACK_COL_MAJOR, m, n, a, m, tau, ws.work(lwork), lwork);
+        }
+        case CHOLESKY:
+            return LAPACKE_dpotrf_work(LAPACK_COL_MAJOR, 'L', n, a, n);
+        }
+        return -1;
+    }
+
+    /**
+     * Solve A×X = B, B is row-major m×nrhs, on exit X is in first n rows.
+     */
+    lapack_int solve(double* b, lapack_int nrhs) const {
+        numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+        // one column is the same in both layouts
+        double* bcol = b;
+        if (nrhs > 1) {
+            bcol = ws.scratch(m * nrhs);
+            numy::lapack::to_col_major(b, m, nrhs, bcol, m);
+        }
+
+        lapack_int info = -1;
+
+        switch (method) {
+        case LU:
+            info = LAPACKE_dgetrs_work(LAPACK_COL_MAJOR, 'T', n, nrhs, a, n, ipiv, bcol, n);
+            break;
+        case QR: {
+            // Qᵀb, then back substitution R×X = (Qᵀb)[0:n]
+            lapack_int lwork = ws.lwork(numy::lapack::R_DORMQR, m, n, nrhs, [&](double* lworkOpt) {
+                return LAPACKE_dormqr_work(LAPACK_COL_MAJOR, 'L', 'T',
+                    m, nrhs, n, a, m, tau, bcol, m, lworkOpt, -1);
+            });
+            if (lwork < 0) return lwork;
+            info = LAPACKE_dormqr_work(LAPACK_COL_MAJOR, 'L', 'T',
+                m, nrhs, n, a, m, tau, bcol, m, ws.work(lwork), lwork);
+            if (info == 0) {
+                info = LAPACKE_dtrtrs_work(LAPACK_COL_MAJOR, 'U', 'N', 'N', n, nrhs, a, m, bcol, m);
+            }
+            break;
+        }
+        case CHOLESKY:
+            info = LAPACKE_dpotrs_work(LAPACK_COL_MAJOR, 'L', n, nrhs, a, n, bcol, n);
+            break;
+        }
+
+        if (nrhs > 1) {
+            numy::lapack::to_row_major(bcol, m, nrhs, m, b);
+        }
+
+        return info;
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * Factorize matrix A.
+ *
+ * argv[0] - A, 2-D tensor, not changed
+ * argv[1] - method, atom :lu, :qr or :cholesky
+ *
+ * Returns factorization object or {:error, info} when LAPACK fails,
+ * for example A is singular (LU) or not positive definite (Cholesky).
+ */
+NUMY_ERL_FUN numy_lapack_factorize(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorA = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensorA == nullptr or !tensorA->isValid() or tensorA->nrDims != 2) {
+        return enif_make_badarg(env);
+    }
+
+    char atom[16];
+    if (!enif_get_atom(env, argv[1], atom, sizeof(atom), ERL_NIF_LATIN1)) {
+        return enif_make_badarg(env);
+    }
+
+    Factorization::Method method;
+    if (0 == strcmp(atom, "lu")) method = Factorization::LU;
+    else if (0 == strcmp(atom, "qr")) method = Factorization::QR;
+    else if (0 == strcmp(atom, "cholesky")) method = Factorization::CHOLESKY;
+    else return enif_make_badarg(env);
+
+    lapack_int m = tensorA->nr_rows();
+    lapack_int n = tensorA->nr_cols();
+
+    if ((method == Factorization::QR)? m < n : m != n) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifFact;
+    Factorization* fact = numy::tnsr::newObject<Factorization>(env, nifFact, method, m, n);
+
+    if (fact == nullptr or !fact->isAllocated()) {
+        return enif_make_badarg(env);
+    }
+
+    fact->load((const double*) tensorA->data);
+
+    lapack_int info = fact->factorize();
+
+    if (info != 0) {
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, info));
+    }
+
+    return nifFact;
+}
+
+/**
+ * Solve A×X = B with factored A.
+ *
+ * argv[0] - factorization object
+ * argv[1] - B, tensor of shape [nrhs, m] or vector [m],
+ *           overwritten by solution X (first n rows for QR)
+ *
+ * Returns LAPACK info, 0 on success.
+ */
+NUMY_ERL_FUN numy_lapack_factor_solve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const Factorization* fact = numy::tnsr::getObject<Factorization>(env, argv[0]);
+    numy::Tensor* tensorB = numy::tnsr::getTensor(env, argv[1]);
+
+    if (fact == nullptr or tensorB == nullptr or !tensorB->isValid() or tensorB->nrDims > 2) {
+        return enif_make_badarg(env);
+    }
+
+    // 1-D tensor is one right hand side column
+    const bool isVector = (tensorB->nrDims == 1);
+    const lapack_int rows = isVector ? tensorB->shape[0] : tensorB->nr_rows();
+    const lapack_int nrhs = isVector ? 1 : tensorB->nr_cols();
+
+    if (rows != fact->m) {
+        return enif_make_badarg(env);
+    }
+
+    lapack_int info = fact->solve(tensorB->dbl_data(), nrhs);
+
+    return enif_make_int(env, info);
+}
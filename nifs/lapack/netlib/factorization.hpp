@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief     Reusable LU, QR and Cholesky factorizations.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_lapack_factorize(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_lapack_factor_solve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
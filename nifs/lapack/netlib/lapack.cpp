@@ -18,11 +18,33 @@
 #include <erl_nif.h>
 #include <lapacke.h>
 #include <cblas.h> 
+#include <gsl/gsl_errno.h>
 
 #include "tensor/tensor.hpp"
 #include "tensor/nif_resource.hpp"
 #include "tensor/vector.hpp"
+#include "tensor/serialize.hpp"
+#include "tensor/shm.hpp"
+#include "tensor/matrix_batch.hpp"
+#include "tensor/reduce.hpp"
+#include "tensor/transpose.hpp"
+#include "tensor/expr.hpp"
+#include "tensor/scan.hpp"
+#include "tensor/rolling.hpp"
+#include "tensor/smoothing.hpp"
+#include "tensor/histogram.hpp"
+#include "tensor/segment.hpp"
 #include "lapack/netlib/blas.hpp"
+#include "lapack/netlib/factorization.hpp"
+#include "lapack/netlib/lls_batch.hpp"
+#include "lapack/netlib/workspace.hpp"
+#include "lapack/netlib/decomposition.hpp"
+#include "lapack/netlib/covariance.hpp"
+#include "lapack/netlib/regression.hpp"
+#include "lapack/netlib/online_lsq.hpp"
+#include "gsl/fit_bspline.hpp"
+#include "gsl/interp.hpp"
+#include "gsl/fft.hpp"
 
 #define UNUSED __attribute__((unused))
 #define NUMY_ERL_FUN static ERL_NIF_TERM
@@ -48,6 +70,10 @@ load_nif(ErlNifEnv* env, void** priv, ERL_NIF_TERM /*info*/)
 
     *priv = (void*)resource;
 
+    // default GSL error handler aborts the process,
+    // GSL NIFs check returned status codes instead
+    gsl_set_error_handler_off();
+
     return 0; // OK
 }
 
@@ -349,27 +375,62 @@ NUMY_ERL_FUN numy_lapack_dgels(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv
     int aNrRows = tensorA->nr_rows();
     int aNrCols = tensorA->nr_cols();
     int nrhs    = tensorB->nr_cols();
-    int lda     = aNrCols;
-    int ldb     = nrhs;
-
-    lapack_int res = LAPACKE_dgels(
-        LAPACK_ROW_MAJOR,  // matrix_layout
-        'N',      // trans: 'N' => A, 'T' => A^T
-        aNrRows,  // M - The number of rows of the matrix A
-        aNrCols,  // N - The number of columns of the matrix A
+    int bNrRows = tensorB->nr_rows();
+
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    // Row-major A is column-major Aᵀ, solve with TRANS='T' so
+    // LAPACKE does not allocate transposed copy of A.
+    // One column of B is the same in both layouts.
+    double* bcol = b;
+    if (nrhs > 1) {
+        bcol = ws.scratch(bNrRows * nrhs);
+        numy::lapack::to_col_major(b, bNrRows, nrhs, bcol, bNrRows);
+    }
+
+    lapack_int lwork = ws.lwork(numy::lapack::R_DGELS, aNrRows, aNrCols, nrhs,
+        [&](double* lworkOpt) {
+            return LAPACKE_dgels_work(LAPACK_COL_MAJOR, 'T', aNrCols, aNrRows, nrhs,
+                a, aNrCols, bcol, bNrRows, lworkOpt, -1);
+        });
+
+    if (lwork < 0) {
+        return enif_make_int(env, lwork);
+    }
+
+    lapack_int res = LAPACKE_dgels_work(
+        LAPACK_COL_MAJOR,  // matrix_layout
+        'T',      // trans: 'N' => A, 'T' => A^T
+        aNrCols,  // M - The number of rows of the matrix A^T
+        aNrRows,  // N - The number of columns of the matrix A^T
         nrhs,     // the number of columns of the matrices B and X
-        a,        // On entry, the M-by-N matrix A. On exit, details of its QR/LQ factorization
-        lda,      // The leading dimension of the array A.  LDA >= max(1,M).
-        b,        // B is M-by-NRHS. On exit, solution X.
-        ldb       // The leading dimension of the array B. LDB >= MAX(1,M,N).
+        a,        // On entry, the N-by-M matrix A^T. On exit, details of its QR/LQ factorization
+        aNrCols,  // The leading dimension of the array A^T
+        bcol,     // B is M-by-NRHS. On exit, solution X.
+        bNrRows,  // The leading dimension of the array B. LDB >= MAX(1,M,N).
+        ws.work(lwork),
+        lwork
     );
 
+    if (nrhs > 1) {
+        numy::lapack::to_row_major(bcol, bNrRows, nrhs, bNrRows, b);
+    }
+
     return enif_make_int(env, res);
 }
 
 static ErlNifFunc nif_funcs[] = {
     {       "create_tensor",   1,           tensor_create,   0},
     {        "tensor_nrelm",   1,            tensor_nrelm,   0},
+    {        "tensor_shape",   1,       numy_tensor_shape,   0},
+    {       "tensor_encode",   2,      numy_tensor_encode,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {       "tensor_decode",   1,      numy_tensor_decode,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {   "tensor_shm_create",   2,  numy_tensor_shm_create,   ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {   "tensor_shm_attach",   1,  numy_tensor_shm_attach,   ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {   "tensor_shm_unlink",   1,  numy_tensor_shm_unlink,   ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"tensor_shm_generation",  1, numy_tensor_shm_generation,   0},
+    {"tensor_shm_begin_update",1, numy_tensor_shm_begin_update, 0},
+    {"tensor_shm_end_update",  1, numy_tensor_shm_end_update,   0},
     {    "nif_numy_version",   0,        nif_numy_version,   0},
     {         "fill_tensor",   2,             tensor_fill,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {         "tensor_data",   2,             tensor_data,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
@@ -379,7 +440,50 @@ static ErlNifFunc nif_funcs[] = {
     {"tensor_load_from_file",  1,numy_tensor_load_from_file, ERL_NIF_DIRTY_JOB_IO_BOUND},
     {          "blas_drotg",   2,         numy_blas_drotg,   0},
     {          "blas_dcopy",   5,         numy_blas_dcopy,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_dscal",   4,         numy_blas_dscal,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_daxpy",   6,         numy_blas_daxpy,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {           "blas_ddot",   5,          numy_blas_ddot,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_dnrm2",   3,         numy_blas_dnrm2,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_dasum",   3,         numy_blas_dasum,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "blas_idamax",   3,        numy_blas_idamax,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {           "blas_drot",   7,          numy_blas_drot,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_drotm",   6,         numy_blas_drotm,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_dgemv",   6,         numy_blas_dgemv,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "blas_dgemm",   7,         numy_blas_dgemm,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {        "batch_matmul",   3,       numy_batch_matmul,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {       "tensor_reduce",   3,      numy_tensor_reduce,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "tensor_permute",   2,     numy_tensor_permute,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "tensor_reshape",   2,     numy_tensor_reshape,                             0},
+    {         "tensor_eval",   4,        numy_tensor_eval,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "tensor_scan",   4,        numy_tensor_scan,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "tensor_diff",   2,        numy_tensor_diff,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "tensor_rolling",   5,     numy_tensor_rolling,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "tensor_ewm",   3,         numy_tensor_ewm,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "tensor_holt",   4,        numy_tensor_holt,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "tensor_histogram",   3,   numy_tensor_histogram,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {     "tensor_digitize",   3,    numy_tensor_digitize,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"tensor_segment_reduce",  3,numy_tensor_segment_reduce, ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {        "lapack_dgels",   2,       numy_lapack_dgels,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {  "lapack_dgels_batch",   2, numy_lapack_dgels_batch,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "lapack_factorize",   2,   numy_lapack_factorize,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    { "lapack_factor_solve",   2,numy_lapack_factor_solve,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "lapack_eigh",   2,        numy_lapack_eigh,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "lapack_svd",   1,         numy_lapack_svd,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "lapack_rsvd",   5,        numy_lapack_rsvd,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {   "lapack_covariance",   2,  numy_lapack_covariance,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "lapack_regress",   5,     numy_lapack_regress,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "online_lsq_new",   2, numy_lapack_online_lsq_new,    0},
+    {   "online_lsq_update",   3, numy_lapack_online_lsq_update, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "online_lsq_solve",   1, numy_lapack_online_lsq_solve,  0},
+    {     "gsl_bspline_new",   2,    numy_gsl_bspline_new,   0},
+    {     "gsl_bspline_fit",   4,    numy_gsl_bspline_fit,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "gsl_bspline_eval",   3,   numy_gsl_bspline_eval,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "gsl_interp_new",   3,     numy_gsl_interp_new,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {     "gsl_interp_eval",   3,    numy_gsl_interp_eval,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {        "gsl_fft_real",   1,       numy_gsl_fft_real,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"gsl_fft_real_inverse",   2,numy_gsl_fft_real_inverse,  ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {     "gsl_fft_complex",   2,    numy_gsl_fft_complex,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "gsl_fft_convolve",   4,       numy_gsl_convolve,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {          "vector_add",   2,         numy_vector_add,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {          "vector_sub",   2,         numy_vector_sub,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {          "vector_mul",   2,         numy_vector_mul,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
@@ -399,7 +503,12 @@ static ErlNifFunc nif_funcs[] = {
     {    "vector_max_index",   1,   numy_vector_max_index,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {    "vector_min_index",   1,   numy_vector_min_index,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {    "vector_heaviside",   2,   numy_vector_heaviside,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
-    {      "vector_sigmoid",   1,     numy_vector_sigmoid,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "vector_sigmoid",   2,     numy_vector_sigmoid,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "vector_exp",   2,         numy_vector_exp,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "vector_log",   2,         numy_vector_log,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {         "vector_tanh",   2,        numy_vector_tanh,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {      "vector_softmax",   2,     numy_vector_softmax,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {    "vector_logsumexp",   2,   numy_vector_logsumexp,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {         "vector_sort",   1,        numy_vector_sort,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {      "vector_reverse",   1,     numy_vector_reverse,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {        "vector_axpby",   4,       numy_vector_axpby,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
@@ -407,7 +516,7 @@ static ErlNifFunc nif_funcs[] = {
     {  "vector_swap_ranges",   5, numy_vector_swap_ranges,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {         "vector_find",   2,        numy_vector_find,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {          "vector_abs",   1,         numy_vector_abs,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
-    {          "vector_pow",   2,         numy_vector_pow,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {          "vector_pow",   3,         numy_vector_pow,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {         "vector_pow2",   1,        numy_vector_pow2,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {        "vector_norm2",   1,       numy_vector_norm2,   ERL_NIF_DIRTY_JOB_CPU_BOUND},
     {              "set_op",   3,             numy_set_op,   ERL_NIF_DIRTY_JOB_CPU_BOUND}
@@ -0,0 +1,147 @@
+/**
+ * @file
+ * @brief     Batched linear least squares.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Solve many independent small least squares problems min‖Aᵢx - bᵢ‖
+ * in one NIF call. Workspace size is queried once for the whole batch,
+ * each thread takes its workspace from the per-thread cache and
+ * reuses it for its part of the batch.
+ *
+ * Row-major m×n matrix A is column-major n×m matrix Aᵀ, so calling
+ * column-major dgels with TRANS='T' solves the original problem
+ * without LAPACKE making transposed copies of A on each call.
+ */
+#include "lapack/netlib/lls_batch.hpp"
+
+#include <vector>
+
+#include <lapacke.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+#include "lapack/netlib/workspace.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+struct LLSBatch
+{
+    lapack_int m, n, nrhs;
+    double* a;     ///< batch of row-major m×n matrices
+    double* b;     ///< batch of row-major m×nrhs matrices
+    lapack_int lwork;
+};
+
+/**
+ * Solve systems [begin, end), store LAPACK info of each system.
+ */
+void solve_range(const LLSBatch& lls, size_t begin, size_t end, lapack_int info[])
+{
+    const lapack_int m = lls.m, n = lls.n, nrhs = lls.nrhs;
+
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    double* work = ws.work(lls.lwork);
+    // column-major copy of B, not needed for single right hand side
+    double* bcol = (nrhs > 1)? ws.scratch(m * nrhs) : nullptr;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        double* a = lls.a + i * m * n;
+        double* b = lls.b + i * m * nrhs;
+
+        if (nrhs > 1) {
+            numy::lapack::to_col_major(b, m, nrhs, bcol, m);
+        }
+
+        info[i] = LAPACKE_dgels_work(LAPACK_COL_MAJOR, 'T', n, m, nrhs,
+            a, n, (nrhs > 1)? bcol : b, m, work, lls.lwork);
+
+        if (nrhs > 1) {
+            numy::lapack::to_row_major(bcol, m, nrhs, m, b);
+        }
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * Solve batch of linear least squares problems with dgels.
+ * Like `lapack_dgels`, A and B are overwritten and solution
+ * is in the first n rows of each B.
+ *
+ * argv[0] - A, 3-D tensor [n, m, batch], m >= n
+ * argv[1] - B, 3-D tensor [nrhs, m, batch] or 2-D [m, batch]
+ *
+ * Returns 0 on success or {:error, index, info} for first failed system.
+ */
+NUMY_ERL_FUN numy_lapack_dgels_batch(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    numy::Tensor* tensorA = numy::tnsr::getTensor(env, argv[0]);
+    numy::Tensor* tensorB = numy::tnsr::getTensor(env, argv[1]);
+
+    if (tensorA == nullptr or !tensorA->isValid() or tensorA->nrDims != 3 or
+        tensorB == nullptr or !tensorB->isValid() or
+        tensorB->nrDims < 2 or tensorB->nrDims > 3)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const bool singleRhs = (tensorB->nrDims == 2);
+
+    LLSBatch lls;
+    lls.n    = tensorA->shape[0];
+    lls.m    = tensorA->shape[1];
+    lls.nrhs = singleRhs ? 1 : tensorB->shape[0];
+    lls.a    = tensorA->dbl_data();
+    lls.b    = tensorB->dbl_data();
+
+    const unsigned batch = tensorA->shape[2];
+
+    if (lls.m < lls.n or
+        (lapack_int) tensorB->shape[singleRhs ? 0 : 1] != lls.m or
+        tensorB->shape[tensorB->nrDims - 1] != batch)
+    {
+        return enif_make_badarg(env);
+    }
+
+    // workspace query, all systems have the same size
+    lls.lwork = numy::lapack::Workspace::local().lwork(numy::lapack::R_DGELS,
+        lls.m, lls.n, lls.nrhs, [&](double* lworkOpt) {
+            return LAPACKE_dgels_work(LAPACK_COL_MAJOR, 'T', lls.n, lls.m, lls.nrhs,
+                lls.a, lls.n, lls.b, lls.m, lworkOpt, -1);
+        });
+
+    if (lls.lwork < 0) {
+        return enif_make_tuple3(env, numy::tnsr::getErrAtom(env),
+            enif_make_int(env, -1), enif_make_int(env, lls.lwork));
+    }
+
+    std::vector<lapack_int> infos(batch, 0);
+
+    // a system is ~m·n² flops, give each thread enough of them
+    const size_t minChunk = std::max<size_t>(1, 100000 / (size_t(lls.m) * lls.n * lls.n + 1));
+
+    numy::par::parallel_for(batch, minChunk, [&](size_t begin, size_t end, unsigned) {
+        solve_range(lls, begin, end, infos.data());
+    });
+
+    for (unsigned i = 0; i < batch; ++i) {
+        if (infos[i] != 0) {
+            return enif_make_tuple3(env, numy::tnsr::getErrAtom(env),
+                enif_make_uint(env, i), enif_make_int(env, infos[i]));
+        }
+    }
+
+    return enif_make_int(env, 0);
+}
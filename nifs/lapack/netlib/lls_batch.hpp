@@ -0,0 +1,12 @@
+/**
+ * @file
+ * @brief     Batched linear least squares.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_lapack_dgels_batch(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -0,0 +1,229 @@
+/**
+ * @file
+ * @brief     Online least squares with Givens QR updates.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * State keeps upper-triangular R and z = Qᵀy of QR factorization of
+ * all rows seen so far, never the rows themselves. New row [x | y]
+ * is absorbed with p Givens rotations (drotg/drot) in O(p²),
+ * what is left of y after the rotations adds to residual sum of squares.
+ * Coefficients are back substitution Rβ = z, also O(p²).
+ *
+ * Exponential forgetting 0 < λ ≤ 1 scales R and z by √λ before each row,
+ * so weight of a row k updates ago is λᵏ.
+ *
+ * State is mutable and can be shared between processes,
+ * updates and solves are serialized by mutex.
+ */
+#include "lapack/netlib/online_lsq.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <cblas.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/object.hpp"
+#include "tensor/nif_resource.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+namespace {
+
+/// R is p×p, like any tensor it must fit in MAX_ELEMENTS doubles.
+constexpr unsigned MAX_COEFS = 23170; // ⌊√MAX_ELEMENTS⌋
+
+static_assert(uint64_t{MAX_COEFS} * MAX_COEFS <= numy::tnsr::MAX_ELEMENTS and
+    uint64_t{MAX_COEFS + 1} * (MAX_COEFS + 1) > numy::tnsr::MAX_ELEMENTS);
+
+struct OnlineLSQ : public numy::Object
+{
+    static unsigned constexpr KIND = numy::Object::K_ONLINE_LSQ;
+
+    const unsigned p;      ///< number of coefficients
+    const double   lambda; ///< forgetting factor
+
+    std::vector<double> r;    ///< row-major upper-triangular p×p R
+    std::vector<double> z;    ///< Qᵀy
+    std::vector<double> xrow; ///< row being absorbed
+    double rss   {0.0};       ///< residual sum of squares
+    double count {0.0};       ///< effective number of rows, Σλᵏ
+
+    ErlNifMutex* mutex;
+
+    OnlineLSQ(unsigned nrCoef, double forgetting):
+        numy::Object(KIND), p(nrCoef), lambda(forgetting),
+        r(size_t{nrCoef} * nrCoef, 0.0), z(nrCoef, 0.0), xrow(nrCoef, 0.0)
+    {
+        mutex = enif_mutex_create((char*) "numy_online_lsq");
+    }
+
+    ~OnlineLSQ() override {
+        if (mutex != nullptr) enif_mutex_destroy(mutex);
+    }
+
+    void forget() {
+        if (lambda == 1.0) return;
+        const double sl = std::sqrt(lambda);
+        cblas_dscal(size_t{p} * p, sl, r.data(), 1);
+        cblas_dscal(p, sl, z.data(), 1);
+        rss *= lambda;
+        count *= lambda;
+    }
+
+    /// Absorb row x with response y.
+    void update(const double* x, double y) {
+        forget();
+
+        std::copy(x, x + p, xrow.begin());
+
+        for (unsigned j = 0; j < p; ++j)
+        {
+            double* rj = r.data() + size_t{j} * p;
+            if (xrow[j] == 0.0) continue;
+
+            double a = rj[j], b = xrow[j], c, s;
+            cblas_drotg(&a, &b, &c, &s);
+            rj[j] = a;
+            xrow[j] = 0.0;
+
+            if (j + 1 < p) {
+                cblas_drot(p - j - 1, rj + j + 1, 1, xrow.data() + j + 1, 1, c, s);
+            }
+
+            const double zj = z[j];
+            z[j] = c * zj + s * y;
+            y    = c * y - s * zj;
+        }
+
+        rss += y * y;
+        count += 1.0;
+    }
+
+    /**
+     * Back substitution Rβ = z.
+     * Returns 0 or 1-based index of zero diagonal element of R.
+     */
+    unsigned solve(double* beta) const {
+        for (unsigned j = 0; j < p; ++j) {
+            if (r[size_t{j} * p + j] == 0.0) return j + 1;
+        }
+        std::copy(z.begin(), z.end(), beta);
+        cblas_dtrsv(CblasRowMajor, CblasUpper, CblasNoTrans, CblasNonUnit,
+            p, r.data(), p, beta, 1);
+        return 0;
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * Create online least squares state.
+ *
+ * argv[0] - number of coefficients p, 1..MAX_COEFS
+ * argv[1] - forgetting factor 0 < λ ≤ 1, 1 is ordinary least squares
+ */
+NUMY_ERL_FUN numy_lapack_online_lsq_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    unsigned p {0};
+    double lambda {1.0};
+
+    if (argc != 2 or !enif_get_uint(env, argv[0], &p) or p == 0 or p > MAX_COEFS or
+        !enif_get_double(env, argv[1], &lambda) or !(lambda > 0.0 and lambda <= 1.0))
+    {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifState;
+    OnlineLSQ* state = numy::tnsr::newObject<OnlineLSQ>(env, nifState, p, lambda);
+
+    if (state == nullptr or state->mutex == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    return nifState;
+}
+
+/**
+ * Absorb batch of rows.
+ *
+ * argv[0] - state
+ * argv[1] - X, tensor [p, k] with k rows, or [p] for one row
+ * argv[2] - y, tensor of k elements
+ *
+ * Returns :ok.
+ */
+NUMY_ERL_FUN numy_lapack_online_lsq_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    OnlineLSQ* state = numy::tnsr::getObject<OnlineLSQ>(env, argv[0]);
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[1]);
+    const numy::Tensor* tensorY = numy::tnsr::getTensor(env, argv[2]);
+
+    if (state == nullptr or
+        tensorX == nullptr or !tensorX->isValid() or tensorX->nrDims > 2 or
+        tensorY == nullptr or !tensorY->isValid() or
+        tensorX->shape[0] != state->p or
+        tensorX->nrElements != tensorY->nrElements * state->p)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const double* x = (const double*) tensorX->data;
+    const double* y = (const double*) tensorY->data;
+
+    enif_mutex_lock(state->mutex);
+    for (unsigned i = 0; i < tensorY->nrElements; ++i) {
+        state->update(x + i * state->p, y[i]);
+    }
+    enif_mutex_unlock(state->mutex);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+/**
+ * Solve for coefficients.
+ *
+ * argv[0] - state
+ *
+ * Returns {coefficients tensor [p], rss, count} or {:error, index}
+ * when R is singular, for example fewer than p rows were seen.
+ */
+NUMY_ERL_FUN numy_lapack_online_lsq_solve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return enif_make_badarg(env);
+    }
+
+    OnlineLSQ* state = numy::tnsr::getObject<OnlineLSQ>(env, argv[0]);
+
+    if (state == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifCoef;
+    const unsigned shapeCoef[1] = {state->p};
+    numy::Tensor* tensorCoef = numy::tnsr::newTensor(env, 1, shapeCoef, nifCoef);
+
+    if (tensorCoef == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    enif_mutex_lock(state->mutex);
+    const unsigned info = state->solve(tensorCoef->dbl_data());
+    const double rss = state->rss, count = state->count;
+    enif_mutex_unlock(state->mutex);
+
+    if (info != 0) {
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_uint(env, info));
+    }
+
+    return enif_make_tuple3(env, nifCoef, enif_make_double(env, rss), enif_make_double(env, count));
+}
@@ -0,0 +1,14 @@
+/**
+ * @file
+ * @brief     Online least squares with Givens QR updates.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_lapack_online_lsq_new(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_lapack_online_lsq_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_lapack_online_lsq_solve(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
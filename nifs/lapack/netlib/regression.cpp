@@ -0,0 +1,202 @@
+/**
+ * @file
+ * @brief     Multiple linear and polynomial regression.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Least squares fit y ≈ Xβ solved with dgels (QR) in one pass:
+ *
+ * - weighted fit scales row i of X and yᵢ by √wᵢ
+ * - ridge penalty λ‖β‖² appends rows √λ·I to X and zeros to y
+ * - polynomial fit of degree k builds Vandermonde rows [1, x, x², …, xᵏ],
+ *   its intercept is not penalized by ridge
+ *
+ * Weighted mean and total sum of squares of y are accumulated
+ * (West's weighted incremental algorithm) while X is copied,
+ * residual sum of squares comes from dgels output, so the fit
+ * makes no extra passes over data. With ridge penalty dgels residual
+ * includes penalty, then RSS is computed from predictions.
+ *
+ * Augmented X is built row-major and passed to dgels as column-major
+ * Xᵀ with TRANS='T', same as `lapack_dgels`.
+ */
+#include "lapack/netlib/regression.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <lapacke.h>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "lapack/netlib/workspace.hpp"
+
+#define DLL_LOCAL __attribute__ ((visibility ("hidden")))
+
+#define NUMY_ERL_FUN ERL_NIF_TERM DLL_LOCAL
+
+/**
+ * Fit linear regression.
+ *
+ * argv[0] - X, design matrix 2-D tensor [p, n], or 1-D tensor [n] of x
+ *           when degree >= 0
+ * argv[1] - y, tensor of n elements
+ * argv[2] - polynomial degree k, -1 when X is design matrix
+ * argv[3] - weights, tensor of n non-negative elements or nil
+ * argv[4] - ridge penalty λ >= 0
+ *
+ * Returns {coefficients tensor [p], rss, r2} or {:error, info},
+ * info > 0 means X has not full rank.
+ */
+NUMY_ERL_FUN numy_lapack_regress(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 5) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensorX = numy::tnsr::getTensor(env, argv[0]);
+    const numy::Tensor* tensorY = numy::tnsr::getTensor(env, argv[1]);
+
+    int degree {-1};
+    double ridge {0.0};
+
+    if (tensorX == nullptr or !tensorX->isValid() or
+        tensorY == nullptr or !tensorY->isValid() or
+        !enif_get_int(env, argv[2], &degree) or
+        !enif_get_double(env, argv[4], &ridge) or ridge < 0.0)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const bool polynomial = (degree >= 0);
+
+    if (!polynomial and tensorX->nrDims != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const lapack_int n = polynomial ? tensorX->nrElements : tensorX->nr_rows();
+    const lapack_int p = polynomial ? degree + 1 : tensorX->nr_cols();
+
+    if ((lapack_int) tensorY->nrElements != n) {
+        return enif_make_badarg(env);
+    }
+
+    const double* w = nullptr;
+    if (!enif_is_atom(env, argv[3])) {
+        const numy::Tensor* tensorW = numy::tnsr::getTensor(env, argv[3]);
+        if (tensorW == nullptr or !tensorW->isValid() or (lapack_int) tensorW->nrElements != n) {
+            return enif_make_badarg(env);
+        }
+        w = (const double*) tensorW->data;
+    }
+
+    const double* x = (const double*) tensorX->data;
+    const double* y = (const double*) tensorY->data;
+
+    // ridge rows, intercept of polynomial is not penalized
+    const lapack_int firstPenalized = polynomial ? 1 : 0;
+    const lapack_int nrRidgeRows = (ridge > 0.0)? p - firstPenalized : 0;
+    const lapack_int m = n + nrRidgeRows;
+    const lapack_int ldb = std::max(m, p);
+
+    std::vector<double> a(m * p, 0.0), b(ldb, 0.0);
+
+    double sumW {0.0}, meanY {0.0}, tss {0.0};
+
+    for (lapack_int i = 0; i < n; ++i)
+    {
+        const double wi = w ? w[i] : 1.0;
+        if (wi < 0.0) {
+            return enif_make_badarg(env);
+        }
+        const double sw = std::sqrt(wi);
+        double* row = a.data() + i * p;
+
+        if (polynomial) {
+            double xk = sw;
+            for (lapack_int j = 0; j < p; ++j) {
+                row[j] = xk;
+                xk *= x[i];
+            }
+        }
+        else {
+            const double* xrow = x + i * p;
+            for (lapack_int j = 0; j < p; ++j) {
+                row[j] = sw * xrow[j];
+            }
+        }
+        b[i] = sw * y[i];
+
+        if (wi > 0.0) {
+            sumW += wi;
+            const double delta = y[i] - meanY;
+            const double r = delta * wi / sumW;
+            meanY += r;
+            tss += (sumW - wi) * delta * r;
+        }
+    }
+
+    const double sqrtRidge = std::sqrt(ridge);
+    for (lapack_int j = 0; j < nrRidgeRows; ++j) {
+        a[(n + j) * p + firstPenalized + j] = sqrtRidge;
+    }
+
+    numy::lapack::Workspace& ws = numy::lapack::Workspace::local();
+
+    lapack_int lwork = ws.lwork(numy::lapack::R_DGELS, m, p, 1, [&](double* lworkOpt) {
+        return LAPACKE_dgels_work(LAPACK_COL_MAJOR, 'T', p, m, 1,
+            a.data(), p, b.data(), ldb, lworkOpt, -1);
+    });
+
+    lapack_int info = (lwork < 0)? lwork :
+        LAPACKE_dgels_work(LAPACK_COL_MAJOR, 'T', p, m, 1,
+            a.data(), p, b.data(), ldb, ws.work(lwork), lwork);
+
+    if (info != 0) {
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env), enif_make_int(env, info));
+    }
+
+    ERL_NIF_TERM nifCoef;
+    const unsigned shapeCoef[1] = {(unsigned) p};
+    numy::Tensor* tensorCoef = numy::tnsr::newTensor(env, 1, shapeCoef, nifCoef);
+
+    if (tensorCoef == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    double* beta = tensorCoef->dbl_data();
+    std::copy(b.begin(), b.begin() + p, beta);
+
+    double rss {0.0};
+
+    if (nrRidgeRows == 0) {
+        // dgels leaves residual of (weighted) rows in b[p:m]
+        for (lapack_int i = p; i < m; ++i) {
+            rss += b[i] * b[i];
+        }
+    }
+    else {
+        for (lapack_int i = 0; i < n; ++i) {
+            double yhat {0.0};
+            if (polynomial) {
+                // Horner
+                for (lapack_int j = p - 1; j >= 0; --j) {
+                    yhat = yhat * x[i] + beta[j];
+                }
+            }
+            else {
+                const double* xrow = x + i * p;
+                for (lapack_int j = 0; j < p; ++j) {
+                    yhat += xrow[j] * beta[j];
+                }
+            }
+            const double r = y[i] - yhat;
+            rss += (w ? w[i] : 1.0) * r * r;
+        }
+    }
+
+    const double r2 = (tss > 0.0)? 1.0 - rss / tss : 0.0;
+
+    return enif_make_tuple3(env, nifCoef, enif_make_double(env, rss), enif_make_double(env, r2));
+}
@@ -0,0 +1,161 @@
+/**
+ * @file
+ * @brief     Per-thread LAPACK workspace cache.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * High level LAPACKE_xxx functions query the workspace size and
+ * malloc/free workspace on every call, with row-major layout they also
+ * allocate transposed copies of all matrices. Bindings call
+ * LAPACKE_xxx_work with column-major layout instead and take workspace
+ * from this cache:
+ *
+ * - optimal LWORK is queried once per routine and dimensions
+ *   and remembered,
+ * - work buffer belongs to the thread and grows on demand,
+ *   it never shrinks, so steady state calls do not allocate.
+ *
+ * Dirty scheduler threads live as long as the VM, so the cache
+ * is reused by all NIF calls that run on the same scheduler.
+ */
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+#include <lapacke.h>
+
+namespace numy::lapack {
+
+/// LAPACK routines that use workspace.
+enum Routine : unsigned {
+    R_DGELS,
+    R_DGEQRF,
+    R_DORMQR,
+    R_DORGQR,
+    R_DSYEVD,
+    R_DSYEVR,
+    R_DGESDD
+};
+
+class Workspace
+{
+    struct Entry {
+        unsigned   routine;
+        lapack_int dims[3];
+        lapack_int lwork;
+        lapack_int liwork;
+    };
+
+    static constexpr size_t MAX_ENTRIES = 32;
+
+    std::vector<Entry>  lworks_;
+    std::vector<double> work_;
+    std::vector<double> scratch_;
+    std::vector<lapack_int> iwork_;
+
+public:
+    /// Workspace of the calling thread.
+    static Workspace& local() {
+        thread_local Workspace ws;
+        return ws;
+    }
+
+    /**
+     * Optimal LWORK and LIWORK for routine with given dimensions.
+     *
+     * When not cached yet, `query(double* lworkOpt, lapack_int* liworkOpt)`
+     * is called, it must run the routine with LWORK=-1 (and LIWORK=-1)
+     * and return LAPACK info.
+     *
+     * Returns 0 or LAPACK info of the failed query.
+     */
+    template<class Query>
+    lapack_int lworks(unsigned routine, lapack_int d0, lapack_int d1, lapack_int d2,
+        lapack_int& lwork, lapack_int& liwork, Query&& query)
+    {
+        for (const Entry& e : lworks_) {
+            if (e.routine == routine and e.dims[0] == d0 and e.dims[1] == d1 and e.dims[2] == d2) {
+                lwork = e.lwork;
+                liwork = e.liwork;
+                return 0;
+            }
+        }
+
+        double lworkOpt {0.0};
+        lapack_int liworkOpt {0};
+        lapack_int info = query(&lworkOpt, &liworkOpt);
+        if (info != 0) {
+            return info;
+        }
+
+        lwork = std::max<lapack_int>(1, (lapack_int) lworkOpt);
+        liwork = std::max<lapack_int>(1, liworkOpt);
+
+        if (lworks_.size() == MAX_ENTRIES) {
+            lworks_.erase(lworks_.begin()); // forget the oldest
+        }
+        lworks_.push_back(Entry{routine, {d0, d1, d2}, lwork, liwork});
+
+        return 0;
+    }
+
+    /**
+     * Optimal LWORK for routine with given dimensions.
+     *
+     * When not cached yet, `query(double* lworkOpt)` is called, it must
+     * run the routine with LWORK=-1 and return LAPACK info.
+     *
+     * Returns LWORK or negative info if the query failed.
+     */
+    template<class Query>
+    lapack_int lwork(unsigned routine, lapack_int d0, lapack_int d1, lapack_int d2, Query&& query)
+    {
+        lapack_int lw {0}, liw {0};
+        lapack_int info = lworks(routine, d0, d1, d2, lw, liw,
+            [&](double* lworkOpt, lapack_int*) { return query(lworkOpt); });
+        if (info != 0) {
+            return (info < 0)? info : -info;
+        }
+        return lw;
+    }
+
+    /// Work array of at least `size` elements.
+    double* work(size_t size) {
+        if (work_.size() < size) work_.resize(size);
+        return work_.data();
+    }
+
+    /// Integer work array of at least `size` elements.
+    lapack_int* iwork(size_t size) {
+        if (iwork_.size() < size) iwork_.resize(size);
+        return iwork_.data();
+    }
+
+    /// Scratch buffer for column-major copies, separate from work().
+    double* scratch(size_t size) {
+        if (scratch_.size() < size) scratch_.resize(size);
+        return scratch_.data();
+    }
+};
+
+/// Copy row-major rows×cols matrix to column-major with leading dimension ld.
+static inline
+void to_col_major(const double* src, lapack_int rows, lapack_int cols, double* dst, lapack_int ld)
+{
+    for (lapack_int r = 0; r < rows; ++r)
+        for (lapack_int c = 0; c < cols; ++c)
+            dst[c * ld + r] = src[r * cols + c];
+}
+
+/// Copy column-major rows×cols matrix with leading dimension ld to row-major.
+static inline
+void to_row_major(const double* src, lapack_int rows, lapack_int cols, lapack_int ld, double* dst)
+{
+    for (lapack_int r = 0; r < rows; ++r)
+        for (lapack_int c = 0; c < cols; ++c)
+            dst[r * cols + c] = src[c * ld + r];
+}
+
+} // namespace numy::lapack
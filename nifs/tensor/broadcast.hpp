@@ -0,0 +1,128 @@
+/**
+ * @file
+ * @brief     Numpy-style broadcasting of elementwise operations.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * In-place A op= B where B is broadcast to shape of A. Dimensions are
+ * matched starting from shape[0], the contiguous one, which is numpy's
+ * trailing dimension; B dimension must be equal to A's or 1, missing
+ * B dimensions are 1.
+ *
+ * Common cases keep inner loop contiguous:
+ * - row broadcast, B matches leading dims of A and is 1 in the rest,
+ *   like bias row [cols] added to every row of [cols, rows];
+ *   B is applied to each contiguous block of A
+ * - column broadcast, B is 1 in leading dims and matches the rest,
+ *   like [1, rows] scaling each row; one B scalar per block of A
+ * - anything else walks outer dims with odometer and does
+ *   row or scalar op over shape[0]
+ *
+ * Op provides `vec(a[], b[], n)` and `scalar(a[], b, n)` loops.
+ */
+#pragma once
+
+#include "tensor/tensor.hpp"
+
+namespace numy::tnsr {
+
+/// Can B be broadcast to shape of A?
+static inline
+bool broadcastable(const numy::Tensor& a, const numy::Tensor& b)
+{
+    if (b.nrDims > a.nrDims) {
+        for (unsigned i = a.nrDims; i < b.nrDims; ++i) {
+            if (b.shape[i] != 1) return false;
+        }
+    }
+    for (unsigned i = 0; i < a.nrDims and i < b.nrDims; ++i) {
+        if (b.shape[i] != a.shape[i] and b.shape[i] != 1) return false;
+    }
+    return true;
+}
+
+template<class Op>
+void broadcast_op2(numy::Tensor& a, const numy::Tensor& b)
+{
+    const unsigned nd = a.nrDims;
+    const unsigned n = a.nrElements;
+
+    double* x = a.dbl_data();
+    const double* y = (const double*) b.data;
+
+    if (b.nrElements == n) {
+        Op::vec(x, y, n);
+        return;
+    }
+
+    if (b.nrElements == 1) {
+        Op::scalar(x, y[0], n);
+        return;
+    }
+
+    unsigned bshape[numy::Tensor::MAX_DIMS];
+    for (unsigned i = 0; i < nd; ++i) {
+        bshape[i] = (i < b.nrDims)? b.shape[i] : 1;
+    }
+
+    // row broadcast: equal leading dims, then ones
+    unsigned k = 0;
+    while (k < nd and bshape[k] == a.shape[k]) ++k;
+    bool rest = true;
+    for (unsigned i = k; i < nd; ++i) rest = rest and (bshape[i] == 1);
+
+    if (rest) {
+        const unsigned inner = b.nrElements;
+        for (unsigned off = 0; off < n; off += inner) {
+            Op::vec(x + off, y, inner);
+        }
+        return;
+    }
+
+    // column broadcast: leading ones, then equal dims
+    k = 0;
+    while (k < nd and bshape[k] == 1) ++k;
+    rest = true;
+    for (unsigned i = k; i < nd; ++i) rest = rest and (bshape[i] == a.shape[i]);
+
+    if (rest) {
+        const unsigned inner = n / b.nrElements;
+        for (unsigned o = 0; o < b.nrElements; ++o) {
+            Op::scalar(x + o * inner, y[o], inner);
+        }
+        return;
+    }
+
+    // general case, B offset follows odometer over dims 1..nd
+    unsigned bstride[numy::Tensor::MAX_DIMS];
+    unsigned stride = 1;
+    for (unsigned i = 0; i < nd; ++i) {
+        bstride[i] = (bshape[i] == 1)? 0 : stride;
+        stride *= bshape[i];
+    }
+
+    const unsigned inner = a.shape[0];
+    const bool innerScalar = (bshape[0] == 1);
+
+    unsigned idx[numy::Tensor::MAX_DIMS] = {0};
+    unsigned boff = 0;
+
+    for (unsigned off = 0; off < n; off += inner)
+    {
+        if (innerScalar) {
+            Op::scalar(x + off, y[boff], inner);
+        }
+        else {
+            Op::vec(x + off, y + boff, inner);
+        }
+
+        for (unsigned d = 1; d < nd; ++d) {
+            boff += bstride[d];
+            if (++idx[d] < a.shape[d]) break;
+            boff -= bstride[d] * a.shape[d];
+            idx[d] = 0;
+        }
+    }
+}
+
+} // namespace numy::tnsr
@@ -0,0 +1,369 @@
+/**
+ * @file
+ * @brief     Fused elementwise expression evaluator.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Expression is compiled by Numy.Lapack.Expr into bytecode for
+ * a stack machine, see Opcode; opcodes must match the Elixir side.
+ *
+ * Tensors are processed tile by tile, TILE elements at a time, every
+ * opcode runs over the whole tile, so the inner loops are simple and
+ * vectorized by the compiler while the interpreter dispatch is paid
+ * once per tile. Stack of tile buffers fits in L1 and inputs are read
+ * once, no temporary tensors are created.
+ *
+ * Stack slot is a pointer to input data, pointer to stack buffer or
+ * a scalar; constant subexpressions are folded into scalars.
+ * exp, log, tanh, sigmoid and pow use vectorized numy::vmath.
+ */
+#include "tensor/expr.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+#include "tensor/vmath.hpp"
+
+namespace {
+
+enum Opcode : uint8_t {
+    OP_ARG = 0,   // push input tensor, operand: input index
+    OP_CONST,     // push constant, operand: constant index
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_LT,
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_NEG,
+    OP_ABS,
+    OP_EXP,
+    OP_SIGMOID,
+    OP_LOG,
+    OP_TANH,
+    OP_LAST
+};
+
+enum class Reduce { NONE, SUM, MEAN, MIN, MAX };
+
+constexpr size_t TILE = 256;
+constexpr unsigned MAX_STACK = 16;
+
+struct Slot {
+    const double* p;
+    double c;
+    bool scalar;
+};
+
+struct Program {
+    const uint8_t* code;
+    size_t size;
+    std::vector<double> consts;
+    std::vector<const double*> args;
+};
+
+/// Check operands and stack use before running anything.
+bool validate(const Program& prog)
+{
+    unsigned sp {0};
+    for (size_t pc = 0; pc < prog.size; ++pc) {
+        const uint8_t op = prog.code[pc];
+        if (op >= OP_LAST) return false;
+        if (op == OP_ARG or op == OP_CONST) {
+            if (++pc == prog.size) return false;
+            const size_t idx = prog.code[pc];
+            if (idx >= ((op == OP_ARG)? prog.args.size() : prog.consts.size())) return false;
+            if (++sp > MAX_STACK) return false;
+        }
+        else if (op >= OP_NEG) {
+            if (sp < 1) return false;
+        }
+        else {
+            if (sp < 2) return false;
+            --sp;
+        }
+    }
+    return sp == 1;
+}
+
+template<class F>
+inline void unary(Slot& a, double* out, size_t n, F f)
+{
+    if (a.scalar) {
+        a.c = f(a.c);
+        return;
+    }
+    const double* x = a.p;
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = f(x[i]);
+    a.p = out;
+}
+
+using MathFun = void (*)(const double* in, double* out, size_t n, numy::vmath::Accuracy acc);
+
+/// Unary op with vectorized numy::vmath array function.
+inline void unary(Slot& a, double* out, size_t n, MathFun f)
+{
+    if (a.scalar) {
+        f(&a.c, &a.c, 1, numy::vmath::Accuracy::ULP1);
+        return;
+    }
+    f(a.p, out, n, numy::vmath::Accuracy::ULP1);
+    a.p = out;
+}
+
+template<class F>
+inline void binary(Slot& a, const Slot& b, double* out, size_t n, F f)
+{
+    if (a.scalar and b.scalar) {
+        a.c = f(a.c, b.c);
+        return;
+    }
+    if (a.scalar) {
+        const double x = a.c; const double* y = b.p;
+        #pragma GCC ivdep
+        for (size_t i = 0; i < n; ++i) out[i] = f(x, y[i]);
+    }
+    else if (b.scalar) {
+        const double* x = a.p; const double y = b.c;
+        #pragma GCC ivdep
+        for (size_t i = 0; i < n; ++i) out[i] = f(x[i], y);
+    }
+    else {
+        const double* x = a.p; const double* y = b.p;
+        #pragma GCC ivdep
+        for (size_t i = 0; i < n; ++i) out[i] = f(x[i], y[i]);
+    }
+    a.p = out;
+    a.scalar = false;
+}
+
+/**
+ * Evaluate program over elements [off, off+n), n <= TILE.
+ * Returns pointer to n results, buf holds MAX_STACK tiles.
+ */
+const double* run(const Program& prog, size_t off, size_t n, double* buf)
+{
+    Slot stack[MAX_STACK];
+    unsigned sp {0};
+
+    for (size_t pc = 0; pc < prog.size; ++pc)
+    {
+        const uint8_t op = prog.code[pc];
+
+        if (op == OP_ARG) {
+            stack[sp++] = Slot{prog.args[prog.code[++pc]] + off, 0.0, false};
+            continue;
+        }
+        if (op == OP_CONST) {
+            stack[sp++] = Slot{nullptr, prog.consts[prog.code[++pc]], true};
+            continue;
+        }
+
+        if (op >= OP_NEG) {
+            Slot& a = stack[sp - 1];
+            double* out = buf + (sp - 1) * TILE;
+            switch (op) {
+            case OP_NEG:     unary(a, out, n, [](double x) { return -x; }); break;
+            case OP_ABS:     unary(a, out, n, [](double x) { return std::abs(x); }); break;
+            case OP_EXP:     unary(a, out, n, MathFun(numy::vmath::exp)); break;
+            case OP_SIGMOID: unary(a, out, n, MathFun(numy::vmath::sigmoid)); break;
+            case OP_LOG:     unary(a, out, n, MathFun(numy::vmath::log)); break;
+            case OP_TANH:    unary(a, out, n, MathFun(numy::vmath::tanh)); break;
+            }
+            continue;
+        }
+
+        --sp;
+        Slot& a = stack[sp - 1];
+        const Slot& b = stack[sp];
+        double* out = buf + (sp - 1) * TILE;
+
+        switch (op) {
+        case OP_ADD: binary(a, b, out, n, [](double x, double y) { return x + y; }); break;
+        case OP_SUB: binary(a, b, out, n, [](double x, double y) { return x - y; }); break;
+        case OP_MUL: binary(a, b, out, n, [](double x, double y) { return x * y; }); break;
+        case OP_DIV: binary(a, b, out, n, [](double x, double y) { return x / y; }); break;
+        case OP_POW:
+            if (b.scalar and !a.scalar) {
+                numy::vmath::pow(a.p, out, n, b.c);
+                a.p = out;
+            }
+            else {
+                binary(a, b, out, n, [](double x, double y) { return std::pow(x, y); });
+            }
+            break;
+        case OP_LT: binary(a, b, out, n, [](double x, double y) { return (x < y)? 1.0 : 0.0; }); break;
+        case OP_LE: binary(a, b, out, n, [](double x, double y) { return (x <= y)? 1.0 : 0.0; }); break;
+        case OP_GT: binary(a, b, out, n, [](double x, double y) { return (x > y)? 1.0 : 0.0; }); break;
+        case OP_GE: binary(a, b, out, n, [](double x, double y) { return (x >= y)? 1.0 : 0.0; }); break;
+        case OP_EQ: binary(a, b, out, n, [](double x, double y) { return (x == y)? 1.0 : 0.0; }); break;
+        case OP_NE: binary(a, b, out, n, [](double x, double y) { return (x != y)? 1.0 : 0.0; }); break;
+        }
+    }
+
+    Slot& r = stack[0];
+    if (r.scalar) {
+        std::fill(buf, buf + n, r.c);
+        return buf;
+    }
+    return r.p;
+}
+
+inline double reduce_tile(Reduce red, double acc, const double* x, size_t n)
+{
+    switch (red) {
+    case Reduce::SUM:
+    case Reduce::MEAN:
+        #pragma GCC ivdep
+        for (size_t i = 0; i < n; ++i) acc += x[i];
+        break;
+    case Reduce::MIN:
+        for (size_t i = 0; i < n; ++i) acc = std::min(acc, x[i]);
+        break;
+    case Reduce::MAX:
+        for (size_t i = 0; i < n; ++i) acc = std::max(acc, x[i]);
+        break;
+    case Reduce::NONE:
+        break;
+    }
+    return acc;
+}
+
+inline double reduce_init(Reduce red)
+{
+    switch (red) {
+    case Reduce::MIN: return std::numeric_limits<double>::infinity();
+    case Reduce::MAX: return -std::numeric_limits<double>::infinity();
+    default:          return 0.0;
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * Evaluate compiled elementwise expression.
+ *
+ * argv[0] - bytecode, binary
+ * argv[1] - constants, list of numbers
+ * argv[2] - inputs, list of tensors with same number of elements
+ * argv[3] - final reduction, atom :sum, :mean, :min, :max or nil
+ *
+ * Returns new tensor of shape of the first input, or number
+ * when reduced.
+ */
+ERL_NIF_TERM numy_tensor_eval(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 4) {
+        return enif_make_badarg(env);
+    }
+
+    ErlNifBinary bin;
+    if (!enif_inspect_binary(env, argv[0], &bin) or bin.size == 0) {
+        return enif_make_badarg(env);
+    }
+
+    Program prog;
+    prog.code = bin.data;
+    prog.size = bin.size;
+
+    ERL_NIF_TERM head, tail, list = argv[1];
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        double c;
+        if (!numy::tnsr::getNumber(env, head, c)) {
+            return enif_make_badarg(env);
+        }
+        prog.consts.push_back(c);
+        list = tail;
+    }
+
+    const numy::Tensor* first {nullptr};
+    list = argv[2];
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        const numy::Tensor* tensor = numy::tnsr::getTensor(env, head);
+        if (tensor == nullptr or !tensor->isValid() or
+            (first != nullptr and tensor->nrElements != first->nrElements))
+        {
+            return enif_make_badarg(env);
+        }
+        if (first == nullptr) first = tensor;
+        prog.args.push_back((const double*) tensor->data);
+        list = tail;
+    }
+
+    char atom[8];
+    Reduce red {Reduce::NONE};
+    if (first == nullptr or !enif_get_atom(env, argv[3], atom, sizeof(atom), ERL_NIF_LATIN1)) {
+        return enif_make_badarg(env);
+    }
+    if (0 == strcmp(atom, "sum"))       red = Reduce::SUM;
+    else if (0 == strcmp(atom, "mean")) red = Reduce::MEAN;
+    else if (0 == strcmp(atom, "min"))  red = Reduce::MIN;
+    else if (0 == strcmp(atom, "max"))  red = Reduce::MAX;
+    else if (0 != strcmp(atom, "nil"))  return enif_make_badarg(env);
+
+    if (!validate(prog)) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t n = first->nrElements;
+    const size_t nrTiles = (n + TILE - 1) / TILE;
+    const size_t minChunk = numy::par::MIN_ELEMENTS / TILE;
+
+    if (red == Reduce::NONE)
+    {
+        ERL_NIF_TERM nifOut;
+        numy::Tensor* out = numy::tnsr::newTensor(env, first->nrDims, first->shape, nifOut);
+
+        if (out == nullptr) {
+            return enif_make_badarg(env);
+        }
+
+        double* dst = out->dbl_data();
+
+        numy::par::parallel_for(nrTiles, minChunk, [&](size_t begin, size_t end, unsigned) {
+            std::vector<double> buf(MAX_STACK * TILE);
+            for (size_t t = begin; t < end; ++t) {
+                const size_t off = t * TILE, len = std::min(TILE, n - off);
+                const double* r = run(prog, off, len, buf.data());
+                std::memcpy(dst + off, r, sizeof(double) * len);
+            }
+        });
+
+        return nifOut;
+    }
+
+    std::vector<double> partial(numy::par::nr_threads(nrTiles, minChunk), reduce_init(red));
+
+    numy::par::parallel_for(nrTiles, minChunk, [&](size_t begin, size_t end, unsigned thread) {
+        std::vector<double> buf(MAX_STACK * TILE);
+        double acc = reduce_init(red);
+        for (size_t t = begin; t < end; ++t) {
+            const size_t off = t * TILE, len = std::min(TILE, n - off);
+            acc = reduce_tile(red, acc, run(prog, off, len, buf.data()), len);
+        }
+        partial[thread] = acc;
+    });
+
+    double result = reduce_init(red);
+    for (double p : partial) {
+        result = reduce_tile(red, result, &p, 1);
+    }
+    if (red == Reduce::MEAN) {
+        result /= n;
+    }
+
+    return enif_make_double(env, result);
+}
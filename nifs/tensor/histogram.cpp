@@ -0,0 +1,343 @@
+/**
+ * @file
+ * @brief     Histograms and binning.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Bins are given by m sorted edges, bin i is [edges[i], edges[i+1]),
+ * the last one includes its right edge, as in numpy.
+ * Fixed-width bins {lo, hi, n} are edges lo + i (hi - lo)/n.
+ *
+ * Bin search has no data-dependent branches:
+ * - fixed width: index from (x - lo)/width, clamped in double domain,
+ *   then corrected by one against exact edges
+ * - explicit edges: binary search with conditional moves, number of
+ *   steps depends only on m
+ * Out of range and NaN elements add 0 to a clamped bin instead of
+ * being skipped.
+ *
+ * Each run of shape[0] elements gets its own histogram. Runs are split
+ * between threads; single long run is split into chunks counted
+ * into per-thread bins, merged at the end. Small histograms keep
+ * several copies per thread, so that equal consecutive bins do not
+ * wait for each other's increments.
+ */
+#include "tensor/histogram.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+/// Histograms up to this size are counted in LANES copies.
+constexpr size_t SMALL_BINS = 4096;
+constexpr size_t LANES = 4;
+
+/// Is edge e left of x: e <= x, or e < x for RIGHT (right-closed) bins.
+template<bool RIGHT>
+inline bool left_of(double e, double x)
+{
+    return RIGHT? e < x : e <= x;
+}
+
+struct FixedBins
+{
+    double lo, inv;
+    size_t n;
+    std::vector<double> edges; // n + 1
+
+    FixedBins(double low, double high, size_t nbins):
+        lo(low), inv(nbins / (high - low)), n(nbins), edges(nbins + 1)
+    {
+        const double width = (high - low) / nbins;
+        for (size_t i = 0; i < n; ++i) edges[i] = low + i * width;
+        edges[n] = high;
+    }
+
+    size_t nr_edges() const { return n + 1; }
+
+    /// Number of edges left of x, NaN is right of all edges.
+    template<bool RIGHT>
+    size_t count(double x) const
+    {
+        double b = (x - lo) * inv + 1.0;
+        b = (b > 0.0)? b : 0.0;
+        b = (b < n + 1.0)? b : n + 1.0;
+        size_t k = (size_t) b;
+
+        // estimate is off by at most one
+        const double* e = edges.data();
+        k -= (k > 0) & !left_of<RIGHT>(e[k - (k > 0)], x);
+        k += (k <= n) & left_of<RIGHT>(e[k - (k > n)], x);
+
+        return (x != x)? n + 1 : k;
+    }
+};
+
+struct EdgeBins
+{
+    const double* edges;
+    size_t m;
+
+    size_t nr_edges() const { return m; }
+
+    template<bool RIGHT>
+    size_t count(double x) const
+    {
+        const double* base = edges;
+        size_t len = m;
+        while (len > 1) {
+            const size_t half = len / 2;
+            base = left_of<RIGHT>(base[half], x)? base + half : base;
+            len -= half;
+        }
+        const size_t k = (base - edges) + left_of<RIGHT>(*base, x);
+
+        return (x != x)? m : k;
+    }
+};
+
+/**
+ * Add x[0..n) with weights w (or 1 when W is false) to histogram of
+ * edges.size()-1 bins held in `lanes` copies.
+ */
+template<bool W, class Bins>
+void count_range(const Bins& bins, const double* x, const double* w, size_t n,
+    double* hist, size_t lanes)
+{
+    const size_t m = bins.nr_edges();
+    const size_t nb = m - 1;
+
+    const size_t mask = lanes - 1;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        const double v = x[i];
+        const size_t k = bins.template count<false>(v);
+
+        // k = 0 below first edge, k = m at or above last edge
+        size_t b = k - (k > 0);
+        b -= (b == nb);
+        const bool in = (k > 0) & ((k < m) | (v == bins.edges[nb]));
+
+        hist[(i & mask) * nb + b] += in? (W? w[i] : 1.0) : 0.0;
+    }
+}
+
+template<class Bins>
+void histogram_run(const Bins& bins, const double* x, const double* w, size_t n,
+    double* out, size_t lanes)
+{
+    const size_t nb = bins.nr_edges() - 1;
+    std::vector<double> hist(lanes * nb, 0.0);
+
+    if (w != nullptr) count_range<true>(bins, x, w, n, hist.data(), lanes);
+    else count_range<false>(bins, x, w, n, hist.data(), lanes);
+
+    for (size_t l = 0; l < lanes; ++l) {
+        const double* src = hist.data() + l * nb;
+        for (size_t b = 0; b < nb; ++b) out[b] += src[b];
+    }
+}
+
+template<class Bins>
+void histogram(const Bins& bins, const double* x, const double* w,
+    size_t len, size_t rows, double* out)
+{
+    const size_t nb = bins.nr_edges() - 1;
+    const size_t lanes = (nb <= SMALL_BINS)? LANES : 1;
+
+    std::fill(out, out + nb * rows, 0.0);
+
+    if (rows > 1) {
+        const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+        numy::par::parallel_for(rows, minChunk, [&](size_t begin, size_t end, unsigned) {
+            for (size_t r = begin; r < end; ++r) {
+                histogram_run(bins, x + r * len, (w != nullptr)? w + r * len : nullptr,
+                    len, out + r * nb, lanes);
+            }
+        });
+        return;
+    }
+
+    // single run, per-thread bins
+    const unsigned nrThreads = numy::par::nr_threads(len, numy::par::MIN_ELEMENTS);
+    std::vector<double> partial(nrThreads * nb, 0.0);
+
+    numy::par::parallel_for(len, numy::par::MIN_ELEMENTS, [&](size_t begin, size_t end, unsigned thread) {
+        histogram_run(bins, x + begin, (w != nullptr)? w + begin : nullptr,
+            end - begin, partial.data() + thread * nb, lanes);
+    });
+
+    for (unsigned t = 0; t < nrThreads; ++t) {
+        const double* src = partial.data() + t * nb;
+        for (size_t b = 0; b < nb; ++b) out[b] += src[b];
+    }
+}
+
+template<bool RIGHT, class Bins>
+void digitize(const Bins& bins, const double* x, double* out, size_t n)
+{
+    numy::par::parallel_for(n, numy::par::MIN_ELEMENTS, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; ++i) {
+            out[i] = bins.template count<RIGHT>(x[i]);
+        }
+    });
+}
+
+/**
+ * Bins from {lo, hi, n} tuple or tensor of sorted edges.
+ * Returns false on bad argument.
+ */
+bool get_bins(ErlNifEnv* env, ERL_NIF_TERM term, size_t minEdges,
+    std::optional<FixedBins>& fixed, EdgeBins& edges)
+{
+    int arity {0};
+    const ERL_NIF_TERM* elems {nullptr};
+
+    if (enif_get_tuple(env, term, &arity, &elems)) {
+        double lo, hi;
+        unsigned n;
+        if (arity != 3 or
+            !numy::tnsr::getNumber(env, elems[0], lo) or !numy::tnsr::getNumber(env, elems[1], hi) or
+            !enif_get_uint(env, elems[2], &n) or n < 1 or
+            !std::isfinite(lo) or !std::isfinite(hi) or !(lo < hi))
+        {
+            return false;
+        }
+        fixed.emplace(lo, hi, n);
+        return true;
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, term);
+    if (tensor == nullptr or !tensor->isValid() or tensor->nrElements < minEdges) {
+        return false;
+    }
+
+    const double* e = (const double*) tensor->data;
+    for (size_t i = 0; i < tensor->nrElements; ++i) {
+        if (std::isnan(e[i]) or (i > 0 and e[i] < e[i - 1])) return false;
+    }
+
+    edges.edges = e;
+    edges.m = tensor->nrElements;
+    return true;
+}
+
+} // anonymous namespace
+
+/**
+ * Histogram of each run of shape[0] elements.
+ *
+ * argv[0] - tensor
+ * argv[1] - bins, {lo, hi, n} for n bins of equal width or tensor
+ *           of sorted edges
+ * argv[2] - weights, tensor of same size or nil
+ *
+ * Returns tensor of counts (sums of weights), shape of input with
+ * shape[0] replaced by number of bins. Values outside of edges
+ * and NaN are not counted.
+ */
+ERL_NIF_TERM numy_tensor_histogram(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    std::optional<FixedBins> fixed;
+    EdgeBins edges {nullptr, 0};
+
+    if (tensor == nullptr or !tensor->isValid() or !get_bins(env, argv[1], 2, fixed, edges)) {
+        return enif_make_badarg(env);
+    }
+
+    const double* w = nullptr;
+    if (!enif_is_atom(env, argv[2])) {
+        const numy::Tensor* tensorW = numy::tnsr::getTensor(env, argv[2]);
+        if (tensorW == nullptr or !tensorW->isValid() or tensorW->nrElements != tensor->nrElements) {
+            return enif_make_badarg(env);
+        }
+        w = (const double*) tensorW->data;
+    }
+
+    const size_t nb = fixed? fixed->n : edges.m - 1;
+
+    unsigned shape[numy::Tensor::MAX_DIMS];
+    std::copy(tensor->shape, tensor->shape + tensor->nrDims, shape);
+    shape[0] = nb;
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, tensor->nrDims, shape, nifOut);
+
+    if (tensorOut == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t len = tensor->shape[0];
+    const size_t rows = tensor->nrElements / len;
+    const double* x = (const double*) tensor->data;
+
+    if (fixed) histogram(*fixed, x, w, len, rows, tensorOut->dbl_data());
+    else histogram(edges, x, w, len, rows, tensorOut->dbl_data());
+
+    return nifOut;
+}
+
+/**
+ * Bin index of each element.
+ *
+ * argv[0] - tensor
+ * argv[1] - bins, {lo, hi, n} or tensor of sorted edges
+ * argv[2] - right, true for edges[i-1] < x <= edges[i],
+ *           false for edges[i-1] <= x < edges[i]
+ *
+ * Returns tensor of indices, 0 is left of all edges,
+ * number of edges is right of all edges and NaN.
+ */
+ERL_NIF_TERM numy_tensor_digitize(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    std::optional<FixedBins> fixed;
+    EdgeBins edges {nullptr, 0};
+
+    if (tensor == nullptr or !tensor->isValid() or !get_bins(env, argv[1], 1, fixed, edges)) {
+        return enif_make_badarg(env);
+    }
+
+    const bool right = enif_is_identical(argv[2], numy::tnsr::getTrueAtom(env));
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* tensorOut = numy::tnsr::newTensor(env, tensor->nrDims, tensor->shape, nifOut);
+
+    if (tensorOut == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* x = (const double*) tensor->data;
+    double* out = tensorOut->dbl_data();
+    const size_t n = tensor->nrElements;
+
+    if (fixed) {
+        if (right) digitize<true>(*fixed, x, out, n);
+        else digitize<false>(*fixed, x, out, n);
+    }
+    else {
+        if (right) digitize<true>(edges, x, out, n);
+        else digitize<false>(edges, x, out, n);
+    }
+
+    return nifOut;
+}
@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief     Histograms and binning.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_tensor_histogram(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_digitize(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -0,0 +1,255 @@
+/**
+ * @file
+ * @brief     Batched operations on many small matrices.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Stack of small matrices is 3-D tensor of shape [cols, rows, batch],
+ * stack of vectors is 2-D tensor of shape [len, batch].
+ * For 2x2 ... 8x8 matrices (3x3 and 4x4 in geometry) BLAS call
+ * overhead is larger than the arithmetic, so they get kernels with
+ * compile time dimensions that compiler fully unrolls: any m, k, n
+ * in 2..4 (3x4 affine transforms, 4x3 etc.) and square 5..8.
+ * Other sizes use generic loops.
+ */
+#include "tensor/matrix_batch.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "tensor/nif_resource.hpp"
+
+namespace {
+
+/// y ← A×x, A is M×K
+template<unsigned M, unsigned K>
+inline void matvec_fixed(const double* __restrict a, const double* __restrict x,
+                         double* __restrict y)
+{
+    #pragma GCC unroll 8
+    for (unsigned i = 0; i < M; ++i) {
+        double sum {0.0};
+        #pragma GCC unroll 8
+        for (unsigned j = 0; j < K; ++j) {
+            sum += a[i * K + j] * x[j];
+        }
+        y[i] = sum;
+    }
+}
+
+/// C ← A×B, A is M×K, B is K×N
+template<unsigned M, unsigned K, unsigned N>
+inline void matmul_fixed(const double* __restrict a, const double* __restrict b,
+                         double* __restrict c)
+{
+    #pragma GCC unroll 8
+    for (unsigned i = 0; i < M; ++i) {
+        double row[N] = {};
+        #pragma GCC unroll 8
+        for (unsigned p = 0; p < K; ++p) {
+            const double aip = a[i * K + p];
+            #pragma GCC unroll 8
+            for (unsigned j = 0; j < N; ++j) {
+                row[j] += aip * b[p * N + j];
+            }
+        }
+        #pragma GCC unroll 8
+        for (unsigned j = 0; j < N; ++j) {
+            c[i * N + j] = row[j];
+        }
+    }
+}
+
+inline void matvec_generic(const double* __restrict a, const double* __restrict x,
+                           double* __restrict y, unsigned m, unsigned k)
+{
+    for (unsigned i = 0; i < m; ++i) {
+        double sum {0.0};
+        for (unsigned j = 0; j < k; ++j) {
+            sum += a[i * k + j] * x[j];
+        }
+        y[i] = sum;
+    }
+}
+
+inline void matmul_generic(const double* __restrict a, const double* __restrict b,
+                           double* __restrict c, unsigned m, unsigned k, unsigned n)
+{
+    for (unsigned i = 0; i < m; ++i) {
+        double* ci = c + i * n;
+        for (unsigned j = 0; j < n; ++j) ci[j] = 0.0;
+        for (unsigned p = 0; p < k; ++p) {
+            const double aip = a[i * k + p];
+            const double* bp = b + p * n;
+            #pragma GCC ivdep
+            for (unsigned j = 0; j < n; ++j) {
+                ci[j] += aip * bp[j];
+            }
+        }
+    }
+}
+
+struct Batch
+{
+    const double* a; unsigned aStride; ///< aStride is 0 when one A is shared
+    const double* b; unsigned bStride;
+    double*       c; unsigned cStride;
+    unsigned count;
+};
+
+template<unsigned M, unsigned K>
+void batch_matvec_fixed(const Batch& bt)
+{
+    for (unsigned i = 0; i < bt.count; ++i) {
+        matvec_fixed<M, K>(bt.a + i * bt.aStride, bt.b + i * bt.bStride, bt.c + i * bt.cStride);
+    }
+}
+
+template<unsigned M, unsigned K, unsigned N>
+void batch_matmul_fixed(const Batch& bt)
+{
+    for (unsigned i = 0; i < bt.count; ++i) {
+        matmul_fixed<M, K, N>(bt.a + i * bt.aStride, bt.b + i * bt.bStride, bt.c + i * bt.cStride);
+    }
+}
+
+using BatchKernel = void (*)(const Batch&);
+
+/// Every m, k, n in [RECT_MIN, RECT_MAX] has its kernel.
+constexpr unsigned RECT_MIN = 2, RECT_MAX = 4;
+constexpr unsigned RECT_SIZES = RECT_MAX - RECT_MIN + 1;
+
+/// Kernels indexed by ((m - RECT_MIN) × RECT_SIZES + k - RECT_MIN).
+template<unsigned... I>
+constexpr std::array<BatchKernel, sizeof...(I)> make_matvec_table(std::integer_sequence<unsigned, I...>)
+{
+    return {batch_matvec_fixed<RECT_MIN + I / RECT_SIZES, RECT_MIN + I % RECT_SIZES>...};
+}
+
+/// Kernels indexed by (((m - RECT_MIN) × RECT_SIZES + k - RECT_MIN) × RECT_SIZES + n - RECT_MIN).
+template<unsigned... I>
+constexpr std::array<BatchKernel, sizeof...(I)> make_matmul_table(std::integer_sequence<unsigned, I...>)
+{
+    return {batch_matmul_fixed<RECT_MIN + I / (RECT_SIZES * RECT_SIZES),
+                               RECT_MIN + I / RECT_SIZES % RECT_SIZES,
+                               RECT_MIN + I % RECT_SIZES>...};
+}
+
+constexpr auto MATVEC_KERNELS =
+    make_matvec_table(std::make_integer_sequence<unsigned, RECT_SIZES * RECT_SIZES>{});
+constexpr auto MATMUL_KERNELS =
+    make_matmul_table(std::make_integer_sequence<unsigned, RECT_SIZES * RECT_SIZES * RECT_SIZES>{});
+
+inline bool in_rect_range(unsigned d) {
+    return d >= RECT_MIN and d <= RECT_MAX;
+}
+
+/// Kernel specialized for m×k by k×n (n is 1 for vectors), nullptr if there is none.
+BatchKernel fixed_size_kernel(unsigned m, unsigned k, unsigned n, bool vectors)
+{
+    if (in_rect_range(m) and in_rect_range(k) and (vectors or in_rect_range(n))) {
+        const unsigned mk = (m - RECT_MIN) * RECT_SIZES + (k - RECT_MIN);
+        return vectors ? MATVEC_KERNELS[mk] : MATMUL_KERNELS[mk * RECT_SIZES + (n - RECT_MIN)];
+    }
+
+    if (m != k or (!vectors and n != k)) {
+        return nullptr;
+    }
+
+    switch (m) {
+        case 5: return vectors ? batch_matvec_fixed<5, 5> : batch_matmul_fixed<5, 5, 5>;
+        case 6: return vectors ? batch_matvec_fixed<6, 6> : batch_matmul_fixed<6, 6, 6>;
+        case 7: return vectors ? batch_matvec_fixed<7, 7> : batch_matmul_fixed<7, 7, 7>;
+        case 8: return vectors ? batch_matvec_fixed<8, 8> : batch_matmul_fixed<8, 8, 8>;
+        default: return nullptr;
+    }
+}
+
+} // anonymous namespace
+
+/**
+ * Multiply stack of small matrices by stack of vectors or matrices.
+ *
+ * argv[0] - A, shape [k, m, batch], or [k, m] to use same A for all
+ * argv[1] - B, vectors of shape [k, batch] or matrices [n, k, batch]
+ * argv[2] - C, output [m, batch] or [n, m, batch], or nil to allocate
+ *
+ * Returns C.
+ */
+ERL_NIF_TERM numy_batch_matmul(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* ta = numy::tnsr::getTensor(env, argv[0]);
+    const numy::Tensor* tb = numy::tnsr::getTensor(env, argv[1]);
+
+    if (ta == nullptr or !ta->isValid() or tb == nullptr or !tb->isValid() or
+        ta->nrDims < 2 or ta->nrDims > 3 or tb->nrDims < 2 or tb->nrDims > 3)
+    {
+        return enif_make_badarg(env);
+    }
+
+    const bool vectors = (tb->nrDims == 2);
+    const unsigned k = ta->shape[0], m = ta->shape[1];
+    const unsigned n = vectors ? 1 : tb->shape[0];
+    const unsigned batch = tb->shape[tb->nrDims - 1];
+    const bool sharedA = (ta->nrDims == 2);
+
+    if ((vectors ? tb->shape[0] : tb->shape[1]) != k or
+        (!sharedA and ta->shape[2] != batch))
+    {
+        return enif_make_badarg(env);
+    }
+
+    unsigned cShape[3];
+    unsigned cDims;
+    if (vectors) { cShape[0] = m; cShape[1] = batch; cDims = 2; }
+    else { cShape[0] = n; cShape[1] = m; cShape[2] = batch; cDims = 3; }
+
+    ERL_NIF_TERM cTerm = argv[2];
+    numy::Tensor* tc {nullptr};
+
+    if (enif_is_identical(argv[2], enif_make_atom(env, "nil"))) {
+        tc = numy::tnsr::newTensor(env, cDims, cShape, cTerm);
+    }
+    else {
+        tc = numy::tnsr::getTensor(env, argv[2]);
+        if (tc != nullptr and (!tc->isValid() or tc->nrDims != cDims or
+            !std::equal(cShape, cShape + cDims, tc->shape)))
+        {
+            tc = nullptr;
+        }
+    }
+
+    if (tc == nullptr or tc->overlaps(*ta) or tc->overlaps(*tb)) {
+        return enif_make_badarg(env);
+    }
+
+    Batch bt {
+        (const double*) ta->data, sharedA ? 0 : m * k,
+        (const double*) tb->data, k * n,
+        tc->dbl_data(),           m * n,
+        batch
+    };
+
+    BatchKernel kernel = fixed_size_kernel(m, k, n, vectors);
+
+    if (kernel != nullptr) {
+        kernel(bt);
+    }
+    else if (vectors) {
+        for (unsigned i = 0; i < batch; ++i) {
+            matvec_generic(bt.a + i * bt.aStride, bt.b + i * bt.bStride, bt.c + i * bt.cStride, m, k);
+        }
+    }
+    else {
+        for (unsigned i = 0; i < batch; ++i) {
+            matmul_generic(bt.a + i * bt.aStride, bt.b + i * bt.bStride, bt.c + i * bt.cStride, m, k, n);
+        }
+    }
+
+    return cTerm;
+}
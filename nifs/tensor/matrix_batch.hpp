@@ -0,0 +1,14 @@
+/**
+ * @file
+ * @brief     Batched operations on many small matrices.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+#include "tensor/tensor.hpp"
+
+ERL_NIF_TERM numy_batch_matmul(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -45,8 +45,7 @@ int numy_upgrade_nif(ErlNifEnv* env, void** priv, void** old_priv, ERL_NIF_TERM
         enif_free(priv);//XXX ??? old_priv
     }
 
-    return load_nif(env, priv, info);
-
+    return numy_load_nif(env, priv, info);
 }
 
 void numy_unload_nif(ErlNifEnv* /*env*/, void* priv)
@@ -144,3 +143,27 @@ ERL_NIF_TERM numy_tensor_create(ErlNifEnv* env, int argc, const ERL_NIF_TERM arg
 
     return nifTensor;
 }
+
+/**
+ * Get shape of a tensor as a list, fastest changing dimension first.
+ */
+ERL_NIF_TERM numy_tensor_shape(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+
+    for (int i = tensor->nrDims - 1; i >= 0; --i) {
+        list = enif_make_list_cell(env, enif_make_uint(env, tensor->shape[i]), list);
+    }
+
+    return list;
+}
@@ -7,14 +7,25 @@
  */
 #pragma once
 
+#include <climits>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
 #include <erl_nif.h>
 
 #include "tensor/tensor.hpp"
+#include "tensor/object.hpp"
 
 namespace numy::tnsr {
 
+/// Most elements of double Tensor, size in bytes must fit in `unsigned` dataSize.
+constexpr uint64_t MAX_ELEMENTS = UINT_MAX / sizeof(double);
+
 /**
- * NIFResource manages Tensor NIF resources. 
+ * NIFResource manages Tensor and Object NIF resources.
  */
 class NIFResource
 {
@@ -23,6 +34,7 @@ public:
 
 private:
     ResType res_type_ = nullptr;
+    ResType obj_res_type_ = nullptr;
 
 public:
     ERL_NIF_TERM ok_atom_, error_atom_, true_atom_, false_atom_;
@@ -49,7 +61,16 @@ public:
             nullptr //ErlNifResourceFlags* tried
         );
 
-        return res_type_;
+        obj_res_type_ = enif_open_resource_type(
+            env,
+            "Elixir.Numy.Object",
+            "resource type Object",
+            this->obj_dtor,
+            (ErlNifResourceFlags)(ERL_NIF_RT_CREATE | ERL_NIF_RT_TAKEOVER),
+            nullptr
+        );
+
+        return (obj_res_type_ == nullptr)? nullptr : res_type_;
     }
 
     static
@@ -62,15 +83,50 @@ public:
                 enif_make_string(env, "Tensor bad magic", ERL_NIF_LATIN1));
         }
         else {
-            if (tensor->data != nullptr) {
+            if (tensor->storage == numy::Tensor::S_SHM) {
+                munmap(tensor->mapBase, tensor->mapSize);
+            }
+            else if (tensor->storage == numy::Tensor::S_VIEW) {
+                enif_release_resource(tensor->mapBase);
+            }
+            else if (tensor->data != nullptr) {
                 enif_free(tensor->data);
             }
         }
     }
 
+    static
+    void obj_dtor(ErlNifEnv* /*env*/, void* obj)
+    {
+        numy::Object* object = (numy::Object*) obj;
+        if (object->magic == numy::Object::MAGIC) {
+            object->~Object();
+        }
+    }
+
+    /**
+     * Allocate Object resource and construct object T in it.
+     */
+    template<class T, class... Args>
+    T* allocateObject(Args&&... args) {
+        void* mem = enif_alloc_resource(obj_res_type_, sizeof(T));
+        return (mem == nullptr)? nullptr : new (mem) T(std::forward<Args>(args)...);
+    }
+
+    template<class T>
+    T* getObject(ErlNifEnv* env, const ERL_NIF_TERM objNifTerm) {
+        numy::Object* obj{nullptr};
+        if (!enif_get_resource(env, objNifTerm, obj_res_type_, (void**) &obj) or
+            obj->magic != numy::Object::MAGIC or obj->kind != T::KIND)
+        {
+            return nullptr;
+        }
+        return static_cast<T*>(obj);
+    }
+
     numy::Tensor* allocate() {
-        return static_cast<numy::Tensor*>(
-            enif_alloc_resource(res_type_, sizeof(numy::Tensor)));
+        void* mem = enif_alloc_resource(res_type_, sizeof(numy::Tensor));
+        return (mem == nullptr)? nullptr : new (mem) numy::Tensor;
     }
 
     numy::Tensor* get(ErlNifEnv* env, const ERL_NIF_TERM tensorNifTerm) {
@@ -87,6 +143,128 @@ numy::Tensor* getTensor(ErlNifEnv* env, const ERL_NIF_TERM nifTensor) {
     return resourceMngr->get(env, nifTensor);
 }
 
+/**
+ * Allocate new Tensor resource of doubles with the given shape.
+ *
+ * Data is not initialized. On success `nifTensor` holds the Erlang term
+ * that owns the resource.
+ */
+static inline
+numy::Tensor* newTensor(ErlNifEnv* env, unsigned nrDims, const unsigned shape[],
+    ERL_NIF_TERM& nifTensor)
+{
+    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
+
+    if (resourceMngr == nullptr or nrDims == 0 or nrDims >= numy::Tensor::MAX_DIMS)
+        return nullptr;
+
+    uint64_t nrElements = 1;
+    for (unsigned i = 0; i < nrDims; ++i) {
+        if (shape[i] == 0) return nullptr;
+        nrElements *= shape[i];
+        if (nrElements > MAX_ELEMENTS) return nullptr;
+    }
+
+    numy::Tensor* tensor = resourceMngr->allocate();
+
+    if (tensor == nullptr)
+        return nullptr;
+
+    nifTensor = enif_make_resource(env, tensor);
+
+    enif_release_resource(tensor);
+
+    tensor->magic      = numy::Tensor::MAGIC;
+    tensor->nrDims     = nrDims;
+    tensor->nrElements = nrElements;
+    tensor->dtype      = numy::Tensor::T_DBL;
+    tensor->dataSize   = nrElements * sizeof(double);
+    tensor->data       = enif_alloc(tensor->dataSize);
+
+    for (unsigned i = 0; i < nrDims; ++i) {
+        tensor->shape[i] = shape[i];
+    }
+
+    return (tensor->data == nullptr)? nullptr : tensor;
+}
+
+/**
+ * Allocate new Tensor resource with the given shape over data of `src`,
+ * data is not copied. Number of elements must be same as in `src`.
+ *
+ * View keeps the resource that owns data alive, writes through
+ * either tensor are seen by both.
+ */
+static inline
+numy::Tensor* newTensorView(ErlNifEnv* env, numy::Tensor* src, unsigned nrDims,
+    const unsigned shape[], ERL_NIF_TERM& nifTensor)
+{
+    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
+
+    if (resourceMngr == nullptr or nrDims == 0 or nrDims >= numy::Tensor::MAX_DIMS)
+        return nullptr;
+
+    numy::Tensor* tensor = resourceMngr->allocate();
+
+    if (tensor == nullptr)
+        return nullptr;
+
+    nifTensor = enif_make_resource(env, tensor);
+
+    enif_release_resource(tensor);
+
+    // view of view shares the original owner
+    void* owner = (src->storage == numy::Tensor::S_VIEW)? src->mapBase : src;
+    enif_keep_resource(owner);
+
+    tensor->magic      = numy::Tensor::MAGIC;
+    tensor->nrDims     = nrDims;
+    tensor->nrElements = src->nrElements;
+    tensor->dtype      = src->dtype;
+    tensor->dataSize   = src->dataSize;
+    tensor->data       = src->data;
+    tensor->storage    = numy::Tensor::S_VIEW;
+    tensor->mapBase    = owner;
+
+    for (unsigned i = 0; i < nrDims; ++i) {
+        tensor->shape[i] = shape[i];
+    }
+
+    return tensor;
+}
+
+/**
+ * Get Object of type T from NIF resource, nullptr if it is not T.
+ */
+template<class T>
+static inline
+T* getObject(ErlNifEnv* env, const ERL_NIF_TERM nifObject) {
+    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
+    return resourceMngr->getObject<T>(env, nifObject);
+}
+
+/**
+ * Create new Object T as NIF resource, `nifObject` is the owning term.
+ */
+template<class T, class... Args>
+static inline
+T* newObject(ErlNifEnv* env, ERL_NIF_TERM& nifObject, Args&&... args)
+{
+    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
+
+    T* obj = (resourceMngr == nullptr)? nullptr :
+        resourceMngr->allocateObject<T>(std::forward<Args>(args)...);
+
+    if (obj == nullptr)
+        return nullptr;
+
+    nifObject = enif_make_resource(env, obj);
+
+    enif_release_resource(obj);
+
+    return obj;
+}
+
 static inline ERL_NIF_TERM getOkAtom(ErlNifEnv* env) {
     return ((NIFResource*) enif_priv_data(env))->ok_atom_;
 }
@@ -107,6 +285,19 @@ static inline ERL_NIF_TERM getBoolAtom(ErlNifEnv* env, bool truth) {
     return truth ? getTrueAtom(env) : getFalseAtom(env);
 }
 
+/**
+ * Get number argument, float or integer, as double.
+ */
+static inline
+bool getNumber(ErlNifEnv* env, ERL_NIF_TERM term, double& val)
+{
+    if (enif_get_double(env, term, &val)) return true;
+    int64_t i {0};
+    if (!enif_get_int64(env, term, &i)) return false;
+    val = i;
+    return true;
+}
+
 } // namespace numy::tnsr
 
 
@@ -115,4 +306,5 @@ int numy_reload_nif(ErlNifEnv* env, void** priv, ERL_NIF_TERM info);
 int numy_upgrade_nif(ErlNifEnv* env, void** priv, void** old_priv, ERL_NIF_TERM info);
 void numy_unload_nif(ErlNifEnv* env, void* priv);
 
-ERL_NIF_TERM numy_tensor_create(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
\ No newline at end of file
+ERL_NIF_TERM numy_tensor_create(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shape(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
\ No newline at end of file
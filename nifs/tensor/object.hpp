@@ -0,0 +1,41 @@
+/**
+ * @file
+ * @brief     Base of native objects kept in NIF resources.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace numy {
+
+/**
+ * Object is native state that lives between NIF calls, like matrix
+ * factorization or solver workspace. Concrete object derives from it
+ * and defines unique `KIND`, resource destructor calls virtual destructor.
+ */
+struct Object
+{
+    static uint64_t constexpr MAGIC = 0x0b1ec7c0ffe;
+
+    enum Kind : unsigned {
+        K_FACTORIZATION = 1,
+        K_ONLINE_LSQ,
+        K_BSPLINE,
+        K_INTERP
+    };
+
+    uint64_t magic = MAGIC; ///< to check we are actually dealing with Object
+    const unsigned kind;
+
+    explicit Object(unsigned k): kind(k) {}
+
+    virtual ~Object() {}
+
+    Object(const Object&) = delete;
+    Object& operator=(const Object&) = delete;
+};
+
+} // end of namespace numy
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief     Split work across threads.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace numy::par {
+
+/**
+ * Elements per thread worth starting a thread for, cheap per element
+ * loops derive `minChunk` from it: MIN_ELEMENTS / elements per item.
+ */
+constexpr size_t MIN_ELEMENTS = 1 << 15;
+
+/**
+ * Number of threads for `count` work items when each thread
+ * should get at least `minChunk` items.
+ */
+static inline
+unsigned nr_threads(size_t count, size_t minChunk)
+{
+    size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    size_t byWork = std::max<size_t>(1, count / std::max<size_t>(1, minChunk));
+    return std::min(hw, byWork);
+}
+
+/**
+ * Split range [0, count) into contiguous chunks and call
+ * `fn(begin, end, threadIndex)` for each chunk, one chunk per thread.
+ * Calling thread processes the first chunk. Small ranges run inline.
+ */
+template<class Fn>
+void parallel_for(size_t count, size_t minChunk, Fn&& fn)
+{
+    const unsigned nrThreads = nr_threads(count, minChunk);
+
+    if (nrThreads <= 1) {
+        fn(size_t{0}, count, 0u);
+        return;
+    }
+
+    const size_t chunk = (count + nrThreads - 1) / nrThreads;
+
+    std::vector<std::thread> threads;
+    threads.reserve(nrThreads - 1);
+
+    for (unsigned t = 1; t < nrThreads; ++t) {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        threads.emplace_back([&fn, begin, end, t]{ fn(begin, end, t); });
+    }
+
+    fn(size_t{0}, std::min(count, chunk), 0u);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace numy::par
@@ -0,0 +1,274 @@
+/**
+ * @file
+ * @brief     Reductions along tensor axes.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Reducing axis k views tensor as [inner, len, outer] block,
+ * inner = shape[0]×…×shape[k-1], len = shape[k], outer is the rest.
+ *
+ * - axis 0 (inner = 1) is contiguous, each output element reduces
+ *   one contiguous run
+ * - other axes are strided, output row of `inner` elements is
+ *   accumulated slice by slice, so memory is still read sequentially
+ *
+ * Outer blocks are independent and split between threads, when there
+ * are fewer of them than threads output rows are split into column tiles.
+ * Several axes are reduced one after another, from the slowest one.
+ */
+#include "tensor/reduce.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+enum class Reduce { SUM, SUMSQ, MIN, MAX };
+
+template<Reduce R>
+inline double init(double x) {
+    return (R == Reduce::SUMSQ)? x * x : x;
+}
+
+template<Reduce R>
+inline double combine(double acc, double x) {
+    switch (R) {
+    case Reduce::SUM:   return acc + x;
+    case Reduce::SUMSQ: return acc + x * x;
+    case Reduce::MIN:   return std::min(acc, x);
+    case Reduce::MAX:   return std::max(acc, x);
+    }
+    return acc;
+}
+
+/// Narrowest column range of output row worth a work item.
+constexpr size_t INNER_TILE = 256;
+
+/**
+ * Work items are (outer block, column tile) pairs. Rows are split
+ * into tiles only when there are fewer outer blocks than threads,
+ * e.g. reducing the slowest axis has outer = 1.
+ */
+size_t inner_tiles(size_t inner, size_t len, size_t outer)
+{
+    if (inner <= INNER_TILE) return 1;
+    const size_t nrThreads = numy::par::nr_threads(inner * len * outer, numy::par::MIN_ELEMENTS);
+    if (outer >= nrThreads) return 1;
+    return std::min((inner + INNER_TILE - 1) / INNER_TILE, (nrThreads + outer - 1) / outer);
+}
+
+template<Reduce R>
+void reduce_axis(const double* in, double* out, size_t inner, size_t len, size_t outer)
+{
+    if (inner == 1) {
+        const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+        numy::par::parallel_for(outer, minChunk, [=](size_t begin, size_t end, unsigned) {
+            for (size_t o = begin; o < end; ++o) {
+                const double* src = in + o * len;
+                double acc = init<R>(src[0]);
+                for (size_t j = 1; j < len; ++j) {
+                    acc = combine<R>(acc, src[j]);
+                }
+                out[o] = acc;
+            }
+        });
+        return;
+    }
+
+    const size_t tiles = inner_tiles(inner, len, outer);
+    const size_t width = (inner + tiles - 1) / tiles;
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / (width * len));
+
+    numy::par::parallel_for(outer * tiles, minChunk, [=](size_t begin, size_t end, unsigned) {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const size_t o = t / tiles;
+            const size_t i0 = (t % tiles) * width, i1 = std::min(inner, i0 + width);
+            const double* src = in + o * len * inner;
+            double* dst = out + o * inner;
+
+            for (size_t i = i0; i < i1; ++i) {
+                dst[i] = init<R>(src[i]);
+            }
+            for (size_t j = 1; j < len; ++j) {
+                const double* slice = src + j * inner;
+                #pragma GCC ivdep
+                for (size_t i = i0; i < i1; ++i) {
+                    dst[i] = combine<R>(dst[i], slice[i]);
+                }
+            }
+        }
+    });
+}
+
+/// Index of max (or min) along axis, stored as double.
+template<bool MAX>
+void arg_axis(const double* in, double* out, size_t inner, size_t len, size_t outer)
+{
+    const size_t tiles = inner_tiles(inner, len, outer);
+    const size_t width = (inner + tiles - 1) / tiles;
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / (width * len));
+
+    numy::par::parallel_for(outer * tiles, minChunk, [=](size_t begin, size_t end, unsigned) {
+        std::vector<double> best(width);
+        for (size_t t = begin; t < end; ++t)
+        {
+            const size_t o = t / tiles;
+            const size_t i0 = (t % tiles) * width, i1 = std::min(inner, i0 + width);
+            const double* src = in + o * len * inner;
+            double* dst = out + o * inner;
+
+            std::copy(src + i0, src + i1, best.begin());
+            std::fill(dst + i0, dst + i1, 0.0);
+
+            for (size_t j = 1; j < len; ++j) {
+                const double* slice = src + j * inner;
+                for (size_t i = i0; i < i1; ++i) {
+                    if (MAX ? slice[i] > best[i - i0] : slice[i] < best[i - i0]) {
+                        best[i - i0] = slice[i];
+                        dst[i] = j;
+                    }
+                }
+            }
+        }
+    });
+}
+
+using AxisFun = void (*)(const double* in, double* out, size_t inner, size_t len, size_t outer);
+
+} // anonymous namespace
+
+/**
+ * Reduce tensor along axes.
+ *
+ * argv[0] - tensor
+ * argv[1] - operation, atom :sum, :mean, :min, :max, :norm (L2),
+ *           :argmax or :argmin
+ * argv[2] - list of axes (indexes into shape) or nil for all axes,
+ *           argmax and argmin take exactly one axis
+ *
+ * Returns new tensor, shape is input shape without reduced axes,
+ * [1] when all axes are reduced.
+ */
+ERL_NIF_TERM numy_tensor_reduce(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    char op[8];
+    if (tensor == nullptr or !tensor->isValid() or
+        !enif_get_atom(env, argv[1], op, sizeof(op), ERL_NIF_LATIN1))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned nd = tensor->nrDims;
+
+    bool reduced[numy::Tensor::MAX_DIMS] = {false};
+    unsigned nrAxes {0};
+
+    if (enif_is_atom(env, argv[2])) {
+        for (unsigned i = 0; i < nd; ++i) reduced[i] = true;
+        nrAxes = nd;
+    }
+    else {
+        ERL_NIF_TERM head, tail, list = argv[2];
+        unsigned axis;
+        while (enif_get_list_cell(env, list, &head, &tail)) {
+            if (!enif_get_uint(env, head, &axis) or axis >= nd or reduced[axis]) {
+                return enif_make_badarg(env);
+            }
+            reduced[axis] = true;
+            ++nrAxes;
+            list = tail;
+        }
+        if (nrAxes == 0) {
+            return enif_make_badarg(env);
+        }
+    }
+
+    AxisFun first {nullptr}, rest {nullptr};
+    bool mean {false}, norm {false};
+
+    if (0 == strcmp(op, "sum"))       { first = rest = reduce_axis<Reduce::SUM>; }
+    else if (0 == strcmp(op, "mean")) { first = rest = reduce_axis<Reduce::SUM>; mean = true; }
+    else if (0 == strcmp(op, "min"))  { first = rest = reduce_axis<Reduce::MIN>; }
+    else if (0 == strcmp(op, "max"))  { first = rest = reduce_axis<Reduce::MAX>; }
+    else if (0 == strcmp(op, "norm")) {
+        first = reduce_axis<Reduce::SUMSQ>; rest = reduce_axis<Reduce::SUM>; norm = true;
+    }
+    else if (0 == strcmp(op, "argmax") and nrAxes == 1) { first = arg_axis<true>; }
+    else if (0 == strcmp(op, "argmin") and nrAxes == 1) { first = arg_axis<false>; }
+    else {
+        return enif_make_badarg(env);
+    }
+
+    unsigned outShape[numy::Tensor::MAX_DIMS];
+    unsigned outDims {0};
+    for (unsigned i = 0; i < nd; ++i) {
+        if (!reduced[i]) outShape[outDims++] = tensor->shape[i];
+    }
+    if (outDims == 0) {
+        outShape[outDims++] = 1;
+    }
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, outDims, outShape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    // current shape while axes are reduced from the slowest one
+    unsigned shape[numy::Tensor::MAX_DIMS];
+    std::copy(tensor->shape, tensor->shape + nd, shape);
+
+    const double* src = (const double*) tensor->data;
+    std::vector<double> buf[2];
+    size_t count {1}; // number of reduced elements per output element
+    bool isFirst {true};
+
+    for (unsigned k = nd; k-- > 0;)
+    {
+        if (!reduced[k]) continue;
+
+        size_t inner {1}, outer {1};
+        for (unsigned i = 0; i < k; ++i) inner *= shape[i];
+        for (unsigned i = k + 1; i < nd; ++i) outer *= shape[i];
+        const size_t len = shape[k];
+
+        const bool isLast = (--nrAxes == 0);
+        double* dst = out->dbl_data();
+        if (!isLast) {
+            std::vector<double>& b = buf[isFirst ? 0 : (src == buf[0].data())? 1 : 0];
+            b.resize(inner * outer);
+            dst = b.data();
+        }
+
+        (isFirst ? first : rest)(src, dst, inner, len, outer);
+
+        count *= len;
+        shape[k] = 1;
+        src = dst;
+        isFirst = false;
+    }
+
+    double* res = out->dbl_data();
+    if (mean) {
+        for (unsigned i = 0; i < out->nrElements; ++i) res[i] /= count;
+    }
+    else if (norm) {
+        for (unsigned i = 0; i < out->nrElements; ++i) res[i] = std::sqrt(res[i]);
+    }
+
+    return nifOut;
+}
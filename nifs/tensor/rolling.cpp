@@ -0,0 +1,281 @@
+/**
+ * @file
+ * @brief     Rolling window statistics.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Trailing window of `window` elements ending at position i,
+ * evaluated at i = min_periods-1, min_periods-1+step, ... along each
+ * row (run of shape[0] elements). Window is clipped at the start of
+ * the row, so the first outputs see min_periods..window elements.
+ *
+ * Window state slides in O(1) per element:
+ *
+ * - sum, mean: running sum, recomputed from the window every
+ *   ANCHOR_WINDOWS windows so rounding errors do not accumulate
+ * - var, std: Welford add/remove of one element, re-anchored the same way
+ * - NaN and inf are only counted, window with any of them gives NaN
+ *   (or inf for sum, mean), so results do not depend on where
+ *   the state was started
+ * - min, max: monotonic deque of indexes, front is the answer,
+ *   each element is pushed and popped once
+ *
+ * When step is not smaller than window, windows do not overlap and
+ * state is rebuilt for each one. Rows are split between threads,
+ * long single row is split into segments of outputs, each segment
+ * warms up its state on the window before its first output.
+ */
+#include "tensor/rolling.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+constexpr size_t ANCHOR_WINDOWS = 16;
+
+/// NaN and infinities in the window, kept out of the running state
+/// so one of them does not poison it after it leaves the window.
+class NonFinite
+{
+    size_t nan_ {0}, pos_ {0}, neg_ {0};
+
+    void count(double v, size_t d) {
+        if (std::isnan(v)) nan_ += d;
+        else if (v > 0) pos_ += d;
+        else neg_ += d;
+    }
+public:
+    void reset() { nan_ = pos_ = neg_ = 0; }
+    /// True if v is finite and goes to the running state.
+    bool add(double v)    { if (std::isfinite(v)) return true; count(v, 1); return false; }
+    bool remove(double v) { if (std::isfinite(v)) return true; count(v, size_t(0) - 1); return false; }
+    bool any() const { return (nan_ + pos_ + neg_) > 0; }
+
+    /// Sum of the window when any() is true, as plain summation gives it.
+    double sum() const {
+        if (nan_ > 0 or (pos_ > 0 and neg_ > 0)) return NAN;
+        return (pos_ > 0)? INFINITY : -INFINITY;
+    }
+};
+
+class SumState
+{
+    double sum_ {0.0};
+    size_t moves_ {0};
+    NonFinite nf_;
+    const bool mean_;
+public:
+    SumState(size_t, bool mean): mean_(mean) {}
+    void reset() { sum_ = 0.0; moves_ = 0; nf_.reset(); }
+    void add(const double* x, size_t i) { if (nf_.add(x[i])) sum_ += x[i]; ++moves_; }
+    void remove(const double* x, size_t i) { if (nf_.remove(x[i])) sum_ -= x[i]; ++moves_; }
+
+    double value(const double* x, size_t lo, size_t hi) {
+        const size_t count = hi - lo;
+        if (nf_.any()) {
+            return nf_.sum();
+        }
+        if (moves_ > ANCHOR_WINDOWS * count) {
+            sum_ = 0.0;
+            for (size_t i = lo; i < hi; ++i) sum_ += x[i];
+            moves_ = 0;
+        }
+        return mean_? sum_ / count : sum_;
+    }
+};
+
+class VarState
+{
+    double mean_ {0.0}, m2_ {0.0};
+    size_t n_ {0}, moves_ {0};
+    NonFinite nf_;
+    const bool std_;
+public:
+    VarState(size_t, bool sd): std_(sd) {}
+    void reset() { mean_ = m2_ = 0.0; n_ = moves_ = 0; nf_.reset(); }
+
+    void add(const double* x, size_t i) {
+        ++moves_;
+        if (!nf_.add(x[i])) return;
+        const double d = x[i] - mean_;
+        mean_ += d / ++n_;
+        m2_ += d * (x[i] - mean_);
+    }
+
+    void remove(const double* x, size_t i) {
+        ++moves_;
+        if (!nf_.remove(x[i])) return;
+        if (--n_ == 0) { mean_ = m2_ = 0.0; return; }
+        const double d = x[i] - mean_;
+        mean_ -= d / n_;
+        m2_ -= d * (x[i] - mean_);
+    }
+
+    /// Sample variance, 0 for one element, NaN if window has NaN or inf.
+    double value(const double* x, size_t lo, size_t hi) {
+        if (nf_.any()) {
+            return NAN;
+        }
+        if (moves_ > ANCHOR_WINDOWS * n_) {
+            double s {0.0};
+            for (size_t i = lo; i < hi; ++i) s += x[i];
+            mean_ = s / n_;
+            m2_ = 0.0;
+            for (size_t i = lo; i < hi; ++i) m2_ += (x[i] - mean_) * (x[i] - mean_);
+            moves_ = 0;
+        }
+        const double var = (n_ > 1)? ((m2_ < 0)? 0.0 : m2_) / (n_ - 1) : 0.0;
+        return std_? std::sqrt(var) : var;
+    }
+};
+
+/// Monotonic deque in a ring buffer of window indexes.
+template<bool MAX>
+class ExtremeState
+{
+    std::vector<size_t> ring_;
+    size_t head_ {0}, size_ {0};
+
+    size_t& at(size_t k) { return ring_[(head_ + k) % ring_.size()]; }
+public:
+    ExtremeState(size_t window, bool): ring_(window + 1) {}
+    void reset() { head_ = size_ = 0; }
+
+    void add(const double* x, size_t i) {
+        // drop elements that can never be the answer again
+        while (size_ > 0 and (MAX? x[at(size_ - 1)] <= x[i] : x[at(size_ - 1)] >= x[i])) --size_;
+        at(size_++) = i;
+    }
+
+    void remove(const double*, size_t i) {
+        if (size_ > 0 and at(0) == i) {
+            head_ = (head_ + 1) % ring_.size();
+            --size_;
+        }
+    }
+
+    double value(const double* x, size_t, size_t) { return x[at(0)]; }
+};
+
+struct Params {
+    size_t window, step, minPeriods;
+};
+
+/// Outputs [kBegin, kEnd) of row x of n elements.
+template<class State>
+void roll(const double* x, double* out, const Params& p, size_t kBegin, size_t kEnd, bool flag)
+{
+    State st(p.window, flag);
+    size_t lo {0}, hi {0}; // state holds [lo, hi)
+
+    for (size_t k = kBegin; k < kEnd; ++k)
+    {
+        const size_t i = p.minPeriods - 1 + k * p.step;
+        const size_t first = (i + 1 > p.window)? i + 1 - p.window : 0;
+
+        if (k == kBegin or first >= hi) {
+            st.reset();
+            lo = hi = first;
+        }
+        for (; lo < first; ++lo) st.remove(x, lo);
+        for (; hi <= i; ++hi) st.add(x, hi);
+
+        out[k] = st.value(x, lo, hi);
+    }
+}
+
+using RollFun = void (*)(const double* x, double* out, const Params& p,
+    size_t kBegin, size_t kEnd, bool flag);
+
+} // anonymous namespace
+
+/**
+ * Rolling window statistic along rows.
+ *
+ * argv[0] - tensor
+ * argv[1] - operation, atom :sum, :mean, :var, :std, :min or :max
+ * argv[2] - window size
+ * argv[3] - step between outputs
+ * argv[4] - min periods, 1..window, elements in the first window
+ *
+ * Returns new tensor, shape[0] is number of windows per row,
+ * (shape[0] - min_periods) / step + 1.
+ */
+ERL_NIF_TERM numy_tensor_rolling(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 5) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    char op[8];
+    unsigned window {0}, step {0}, minPeriods {0};
+    if (tensor == nullptr or !tensor->isValid() or
+        !enif_get_atom(env, argv[1], op, sizeof(op), ERL_NIF_LATIN1) or
+        !enif_get_uint(env, argv[2], &window) or
+        !enif_get_uint(env, argv[3], &step) or
+        !enif_get_uint(env, argv[4], &minPeriods) or
+        window == 0 or step == 0 or minPeriods == 0 or minPeriods > window or
+        minPeriods > tensor->shape[0])
+    {
+        return enif_make_badarg(env);
+    }
+
+    RollFun fn {nullptr};
+    bool flag {false};
+    if (0 == strcmp(op, "sum"))       { fn = roll<SumState>; }
+    else if (0 == strcmp(op, "mean")) { fn = roll<SumState>; flag = true; }
+    else if (0 == strcmp(op, "var"))  { fn = roll<VarState>; }
+    else if (0 == strcmp(op, "std"))  { fn = roll<VarState>; flag = true; }
+    else if (0 == strcmp(op, "min"))  { fn = roll<ExtremeState<false>>; }
+    else if (0 == strcmp(op, "max"))  { fn = roll<ExtremeState<true>>; }
+    else {
+        return enif_make_badarg(env);
+    }
+
+    const Params p {window, step, minPeriods};
+    const size_t len = tensor->shape[0];
+    const size_t rows = tensor->nrElements / len;
+    const size_t outLen = (len - minPeriods) / step + 1;
+
+    unsigned outShape[numy::Tensor::MAX_DIMS];
+    std::copy(tensor->shape, tensor->shape + tensor->nrDims, outShape);
+    outShape[0] = outLen;
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, tensor->nrDims, outShape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* in = (const double*) tensor->data;
+    double* dst = out->dbl_data();
+
+    if (rows > 1) {
+        const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+        numy::par::parallel_for(rows, minChunk, [=](size_t begin, size_t end, unsigned) {
+            for (size_t r = begin; r < end; ++r) {
+                fn(in + r * len, dst + r * outLen, p, 0, outLen, flag);
+            }
+        });
+    }
+    else {
+        // each segment re-reads up to one window before its first output
+        const size_t perOutput = std::min<size_t>(step, window);
+        const size_t minChunk = std::max<size_t>(window, numy::par::MIN_ELEMENTS / perOutput);
+        numy::par::parallel_for(outLen, minChunk, [=](size_t begin, size_t end, unsigned) {
+            fn(in, dst, p, begin, end, flag);
+        });
+    }
+
+    return nifOut;
+}
@@ -0,0 +1,12 @@
+/**
+ * @file
+ * @brief     Rolling window statistics.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_tensor_rolling(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
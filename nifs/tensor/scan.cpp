@@ -0,0 +1,268 @@
+/**
+ * @file
+ * @brief     Prefix scans and differences.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Scans run along each row, a row is a run of shape[0] elements,
+ * so 1-D tensor is one series and [len, n] tensor is n series.
+ *
+ * Many rows are split between threads. Long row is scanned in two
+ * passes over blocks, one block per thread: first pass folds each
+ * block into its total, block offsets are prefix of the totals,
+ * second pass scans each block starting from its offset.
+ *
+ * Running sum is compensated (Neumaier), it carries the rounding
+ * error of each addition, so long sums do not drift; block totals
+ * are combined with the same compensation.
+ */
+#include "tensor/scan.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+struct SumScan {
+    struct State { double s, c; };
+    static State identity() { return State{0.0, 0.0}; }
+    static void add(State& st, double x) {
+        const double t = st.s + x;
+        st.c += (std::abs(st.s) >= std::abs(x))? (st.s - t) + x : (x - t) + st.s;
+        st.s = t;
+    }
+    static double value(const State& st) { return st.s + st.c; }
+    static State combine(State a, const State& b) { add(a, b.s); a.c += b.c; return a; }
+};
+
+struct ProdScan {
+    using State = double;
+    static State identity() { return 1.0; }
+    static void add(State& st, double x) { st *= x; }
+    static double value(State st) { return st; }
+    static State combine(State a, State b) { return a * b; }
+};
+
+struct MaxScan {
+    using State = double;
+    static State identity() { return -std::numeric_limits<double>::infinity(); }
+    static void add(State& st, double x) { st = std::max(st, x); }
+    static double value(State st) { return st; }
+    static State combine(State a, State b) { return std::max(a, b); }
+};
+
+struct MinScan {
+    using State = double;
+    static State identity() { return std::numeric_limits<double>::infinity(); }
+    static void add(State& st, double x) { st = std::min(st, x); }
+    static double value(State st) { return st; }
+    static State combine(State a, State b) { return std::min(a, b); }
+};
+
+/// Scan n elements starting from state st, `out` may be same as `in`.
+template<class Op>
+typename Op::State scan_run(const double* in, double* out, size_t n,
+    typename Op::State st, bool exclusive)
+{
+    if (exclusive) {
+        for (size_t i = 0; i < n; ++i) {
+            const double x = in[i];
+            out[i] = Op::value(st);
+            Op::add(st, x);
+        }
+    }
+    else {
+        for (size_t i = 0; i < n; ++i) {
+            Op::add(st, in[i]);
+            out[i] = Op::value(st);
+        }
+    }
+    return st;
+}
+
+template<class Op>
+void scan_rows(const double* in, double* out, size_t len, size_t rows, bool exclusive)
+{
+    using State = typename Op::State;
+
+    if (rows > 1) {
+        const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+        numy::par::parallel_for(rows, minChunk, [=](size_t begin, size_t end, unsigned) {
+            for (size_t r = begin; r < end; ++r) {
+                scan_run<Op>(in + r * len, out + r * len, len, Op::identity(), exclusive);
+            }
+        });
+        return;
+    }
+
+    const size_t nrBlocks = numy::par::nr_threads(len, numy::par::MIN_ELEMENTS);
+
+    if (nrBlocks <= 1) {
+        scan_run<Op>(in, out, len, Op::identity(), exclusive);
+        return;
+    }
+
+    const size_t block = (len + nrBlocks - 1) / nrBlocks;
+    std::vector<State> offset(nrBlocks, Op::identity());
+
+    // pass 1: block totals
+    numy::par::parallel_for(nrBlocks, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t b = begin; b < end; ++b) {
+            const size_t lo = std::min(len, b * block), hi = std::min(len, lo + block);
+            State st = Op::identity();
+            for (size_t i = lo; i < hi; ++i) Op::add(st, in[i]);
+            offset[b] = st;
+        }
+    });
+
+    // exclusive prefix of the totals
+    State acc = Op::identity();
+    for (size_t b = 0; b < nrBlocks; ++b) {
+        const State total = offset[b];
+        offset[b] = acc;
+        acc = Op::combine(acc, total);
+    }
+
+    // pass 2: scan blocks from their offsets
+    numy::par::parallel_for(nrBlocks, 1, [&](size_t begin, size_t end, unsigned) {
+        for (size_t b = begin; b < end; ++b) {
+            const size_t lo = std::min(len, b * block), hi = std::min(len, lo + block);
+            scan_run<Op>(in + lo, out + lo, hi - lo, offset[b], exclusive);
+        }
+    });
+}
+
+using ScanFun = void (*)(const double* in, double* out, size_t len, size_t rows, bool exclusive);
+
+} // anonymous namespace
+
+/**
+ * Prefix scan along rows.
+ *
+ * argv[0] - tensor
+ * argv[1] - operation, atom :sum, :prod, :max or :min
+ * argv[2] - exclusive, true or false; exclusive scan starts with
+ *           identity: 0, 1, -inf or +inf
+ * argv[3] - in place, true or false
+ *
+ * Returns :ok when in place, otherwise new tensor of same shape.
+ */
+ERL_NIF_TERM numy_tensor_scan(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 4) {
+        return enif_make_badarg(env);
+    }
+
+    numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    char op[8];
+    if (tensor == nullptr or !tensor->isValid() or tensor->nrElements == 0 or
+        !enif_get_atom(env, argv[1], op, sizeof(op), ERL_NIF_LATIN1))
+    {
+        return enif_make_badarg(env);
+    }
+
+    ScanFun scan {nullptr};
+    if (0 == strcmp(op, "sum"))       scan = scan_rows<SumScan>;
+    else if (0 == strcmp(op, "prod")) scan = scan_rows<ProdScan>;
+    else if (0 == strcmp(op, "max"))  scan = scan_rows<MaxScan>;
+    else if (0 == strcmp(op, "min"))  scan = scan_rows<MinScan>;
+    else {
+        return enif_make_badarg(env);
+    }
+
+    const bool exclusive = enif_is_identical(argv[2], numy::tnsr::getTrueAtom(env));
+    const bool inPlace = enif_is_identical(argv[3], numy::tnsr::getTrueAtom(env));
+
+    const size_t len = tensor->shape[0];
+    const size_t rows = tensor->nrElements / len;
+    const double* in = (const double*) tensor->data;
+
+    if (inPlace) {
+        scan(in, tensor->dbl_data(), len, rows, exclusive);
+        return numy::tnsr::getOkAtom(env);
+    }
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, tensor->nrDims, tensor->shape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    scan(in, out->dbl_data(), len, rows, exclusive);
+
+    return nifOut;
+}
+
+/**
+ * n-th order difference along rows, out[i] = x[i+1] - x[i] applied n times.
+ *
+ * argv[0] - tensor
+ * argv[1] - order n, 0 < n < shape[0]
+ *
+ * Returns new tensor, shape[0] is shorter by n.
+ */
+ERL_NIF_TERM numy_tensor_diff(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    unsigned order {0};
+    if (tensor == nullptr or !tensor->isValid() or
+        !enif_get_uint(env, argv[1], &order) or order == 0 or order >= tensor->shape[0])
+    {
+        return enif_make_badarg(env);
+    }
+
+    unsigned outShape[numy::Tensor::MAX_DIMS];
+    std::copy(tensor->shape, tensor->shape + tensor->nrDims, outShape);
+    outShape[0] -= order;
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, tensor->nrDims, outShape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t len = tensor->shape[0];
+    const size_t outLen = outShape[0];
+    const size_t rows = tensor->nrElements / len;
+    const double* in = (const double*) tensor->data;
+    double* dst = out->dbl_data();
+
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / (len * order));
+
+    numy::par::parallel_for(rows, minChunk, [=](size_t begin, size_t end, unsigned) {
+        std::vector<double> buf;
+        for (size_t r = begin; r < end; ++r) {
+            const double* x = in + r * len;
+            double* y = dst + r * outLen;
+
+            if (order == 1) {
+                #pragma GCC ivdep
+                for (size_t i = 0; i < outLen; ++i) y[i] = x[i + 1] - x[i];
+                continue;
+            }
+
+            buf.assign(x, x + len);
+            for (size_t k = 1, n = len; k <= order; ++k, --n) {
+                for (size_t i = 0; i + 1 < n; ++i) buf[i] = buf[i + 1] - buf[i];
+            }
+            std::copy(buf.begin(), buf.begin() + outLen, y);
+        }
+    });
+
+    return nifOut;
+}
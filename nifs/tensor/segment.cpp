@@ -0,0 +1,300 @@
+/**
+ * @file
+ * @brief     Segmented (group-by) reductions.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Values are reduced by integer group id, ids are given by a tensor
+ * of the same size. Input is split into one chunk per thread and each
+ * thread reduces its chunk into its own table, tables are merged at
+ * the end.
+ *
+ * - sorted ids (non-decreasing) form segments, a thread table is a list
+ *   of segments in order; adjacent chunks share at most one segment
+ * - unsorted ids go to open addressing hash table per thread,
+ *   merged tables are sorted by id
+ *
+ * Either way groups come out in ascending id order.
+ */
+#include "tensor/segment.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+/// Reduction value and number of elements in group.
+struct Acc { double v, n; };
+
+struct SumSeg {
+    static double identity() { return 0.0; }
+    static double add(double v, double x) { return v + x; }
+    static double finish(const Acc& a) { return a.v; }
+};
+
+struct MeanSeg : SumSeg {
+    static double finish(const Acc& a) { return a.v / a.n; }
+};
+
+struct CountSeg : SumSeg {
+    static double add(double v, double) { return v; }
+    static double finish(const Acc& a) { return a.n; }
+};
+
+struct MinSeg {
+    static double identity() { return std::numeric_limits<double>::infinity(); }
+    static double add(double v, double x) { return (x < v)? x : v; }
+    static double finish(const Acc& a) { return a.v; }
+};
+
+struct MaxSeg {
+    static double identity() { return -std::numeric_limits<double>::infinity(); }
+    static double add(double v, double x) { return (x > v)? x : v; }
+    static double finish(const Acc& a) { return a.v; }
+};
+
+template<class Op>
+inline void merge(Acc& a, const Acc& b)
+{
+    a.v = Op::add(a.v, b.v);
+    a.n += b.n;
+}
+
+struct Group {
+    int64_t key;
+    Acc acc;
+};
+
+/**
+ * Open addressing hash table with linear probing,
+ * empty slot has count 0.
+ */
+template<class Op>
+class GroupTable
+{
+    std::vector<Group> slots;
+    size_t size {0};
+    unsigned shift;
+
+    size_t slot_of(int64_t key) const {
+        return ((uint64_t) key * 0x9E3779B97F4A7C15ull) >> shift;
+    }
+
+    void grow() {
+        std::vector<Group> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, Group{0, Acc{Op::identity(), 0.0}});
+        --shift;
+        for (const Group& g : old) {
+            if (g.acc.n == 0.0) continue;
+            size_t i = slot_of(g.key);
+            while (slots[i].acc.n != 0.0) i = (i + 1) & (slots.size() - 1);
+            slots[i] = g;
+        }
+    }
+
+public:
+    explicit GroupTable(unsigned log2Capacity = 10):
+        slots(size_t{1} << log2Capacity, Group{0, Acc{Op::identity(), 0.0}}),
+        shift(64 - log2Capacity)
+    {}
+
+    /// Accumulator of group `key`, created when missing.
+    Acc& find(int64_t key) {
+        const size_t mask = slots.size() - 1;
+        size_t i = slot_of(key);
+        while (slots[i].acc.n != 0.0) {
+            if (slots[i].key == key) return slots[i].acc;
+            i = (i + 1) & mask;
+        }
+        if (2 * (size + 1) > slots.size()) {
+            grow();
+            return find(key);
+        }
+        ++size;
+        slots[i].key = key;
+        return slots[i].acc;
+    }
+
+    void add(int64_t key, double x) {
+        Acc& a = find(key);
+        a.v = Op::add(a.v, x);
+        a.n += 1.0;
+    }
+
+    void merge_into(GroupTable& other) const {
+        for (const Group& g : slots) {
+            if (g.acc.n != 0.0) merge<Op>(other.find(g.key), g.acc);
+        }
+    }
+
+    void extract(std::vector<Group>& out) const {
+        out.reserve(size);
+        for (const Group& g : slots) {
+            if (g.acc.n != 0.0) out.push_back(g);
+        }
+    }
+};
+
+template<class Op>
+void reduce_sorted(const double* x, const double* ids, size_t n, std::vector<Group>& out)
+{
+    const unsigned nrThreads = numy::par::nr_threads(n, numy::par::MIN_ELEMENTS);
+    std::vector<std::vector<Group>> segments(nrThreads);
+
+    numy::par::parallel_for(n, numy::par::MIN_ELEMENTS, [&](size_t begin, size_t end, unsigned thread) {
+        std::vector<Group>& seg = segments[thread];
+        size_t i = begin;
+        while (i < end) {
+            const double id = ids[i];
+            const size_t first = i;
+            double v = Op::identity();
+            for (; i < end and ids[i] == id; ++i) {
+                v = Op::add(v, x[i]);
+            }
+            seg.push_back(Group{(int64_t) id, Acc{v, double(i - first)}});
+        }
+    });
+
+    for (auto& seg : segments) {
+        for (const Group& g : seg) {
+            if (!out.empty() and out.back().key == g.key) merge<Op>(out.back().acc, g.acc);
+            else out.push_back(g);
+        }
+    }
+}
+
+template<class Op>
+void reduce_hashed(const double* x, const double* ids, size_t n, std::vector<Group>& out)
+{
+    const unsigned nrThreads = numy::par::nr_threads(n, numy::par::MIN_ELEMENTS);
+    std::vector<GroupTable<Op>> tables(nrThreads);
+
+    numy::par::parallel_for(n, numy::par::MIN_ELEMENTS, [&](size_t begin, size_t end, unsigned thread) {
+        GroupTable<Op>& table = tables[thread];
+        for (size_t i = begin; i < end; ++i) {
+            table.add((int64_t) ids[i], x[i]);
+        }
+    });
+
+    for (unsigned t = 1; t < nrThreads; ++t) {
+        tables[t].merge_into(tables[0]);
+    }
+
+    tables[0].extract(out);
+    std::sort(out.begin(), out.end(), [](const Group& a, const Group& b) { return a.key < b.key; });
+}
+
+template<class Op>
+ERL_NIF_TERM segment_reduce(ErlNifEnv* env, const double* x, const double* ids, size_t n, bool sorted)
+{
+    std::vector<Group> groups;
+    if (sorted) reduce_sorted<Op>(x, ids, n, groups);
+    else reduce_hashed<Op>(x, ids, n, groups);
+
+    unsigned shape[1] = {(unsigned) groups.size()};
+    ERL_NIF_TERM nifKeys, nifOut;
+    numy::Tensor* keys = numy::tnsr::newTensor(env, 1, shape, nifKeys);
+    numy::Tensor* out = numy::tnsr::newTensor(env, 1, shape, nifOut);
+
+    if (keys == nullptr or out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    double* k = keys->dbl_data();
+    double* o = out->dbl_data();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        k[g] = groups[g].key;
+        o[g] = Op::finish(groups[g].acc);
+    }
+
+    return enif_make_tuple2(env, nifKeys, nifOut);
+}
+
+/**
+ * Check that all ids are integers in int64 range.
+ * Returns false if not, `sorted` tells if they are non-decreasing.
+ */
+bool check_ids(const double* ids, size_t n, bool& sorted)
+{
+    constexpr double LIMIT = 0x1p63;
+
+    const unsigned nrThreads = numy::par::nr_threads(n, numy::par::MIN_ELEMENTS);
+    std::vector<char> valid(nrThreads, 1), ordered(nrThreads, 1);
+
+    numy::par::parallel_for(n, numy::par::MIN_ELEMENTS, [&](size_t begin, size_t end, unsigned thread) {
+        bool ok = true, up = true;
+        for (size_t i = begin; i < end; ++i) {
+            const double id = ids[i];
+            ok = ok & (id == std::trunc(id)) & (id >= -LIMIT) & (id < LIMIT);
+            up = up & ((i == 0) or (ids[i - 1] <= id));
+        }
+        valid[thread] = ok;
+        ordered[thread] = up;
+    });
+
+    sorted = std::all_of(ordered.begin(), ordered.end(), [](char c) { return c != 0; });
+    return std::all_of(valid.begin(), valid.end(), [](char c) { return c != 0; });
+}
+
+} // anonymous namespace
+
+/**
+ * Reduce values by group id.
+ *
+ * argv[0] - values tensor
+ * argv[1] - group ids, tensor of integers, same size as values
+ * argv[2] - operation, atom :sum, :mean, :count, :min or :max
+ *
+ * Returns {ids, results}, tensors of distinct ids in ascending order
+ * and result for each of them.
+ */
+ERL_NIF_TERM numy_tensor_segment_reduce(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+    const numy::Tensor* tensorIds = numy::tnsr::getTensor(env, argv[1]);
+
+    char op[8];
+    if (tensor == nullptr or !tensor->isValid() or tensor->nrElements == 0 or
+        tensorIds == nullptr or !tensorIds->isValid() or
+        tensorIds->nrElements != tensor->nrElements or
+        !enif_get_atom(env, argv[2], op, sizeof(op), ERL_NIF_LATIN1))
+    {
+        return enif_make_badarg(env);
+    }
+
+    using ReduceFun = ERL_NIF_TERM (*)(ErlNifEnv*, const double*, const double*, size_t, bool);
+
+    ReduceFun reduce {nullptr};
+    if (0 == strcmp(op, "sum"))        reduce = segment_reduce<SumSeg>;
+    else if (0 == strcmp(op, "mean"))  reduce = segment_reduce<MeanSeg>;
+    else if (0 == strcmp(op, "count")) reduce = segment_reduce<CountSeg>;
+    else if (0 == strcmp(op, "min"))   reduce = segment_reduce<MinSeg>;
+    else if (0 == strcmp(op, "max"))   reduce = segment_reduce<MaxSeg>;
+    else {
+        return enif_make_badarg(env);
+    }
+
+    const double* x = (const double*) tensor->data;
+    const double* ids = (const double*) tensorIds->data;
+    const size_t n = tensor->nrElements;
+
+    bool sorted {false};
+    if (!check_ids(ids, n, sorted)) {
+        return enif_make_badarg(env);
+    }
+
+    return reduce(env, x, ids, n, sorted);
+}
@@ -0,0 +1,248 @@
+/**
+ * @file
+ * @brief     Tensor serialization to/from Erlang binary.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Tensor NIF resource can't be sent to other node, but a binary can.
+ * Encoded binary is self-describing: header with dtype and shape
+ * is followed by the payload, so decoding is a single memcpy
+ * into newly allocated Tensor.
+ *
+ * Optional compression shuffles bytes of elements (all 1st bytes,
+ * then all 2nd bytes, ...) before deflating, exponent bytes
+ * of floating point numbers compress well when grouped together.
+ */
+#include "tensor/serialize.hpp"
+
+#include <cstring>
+
+#include <zlib.h>
+
+#include "tensor/nif_resource.hpp"
+
+using numy::tnsr::BinaryHeader;
+using numy::tnsr::binary_header_size;
+using numy::tnsr::write_binary_header;
+
+static constexpr uint8_t HOST_ENDIAN_FLAG =
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    BinaryHeader::F_BIG_ENDIAN;
+#else
+    0;
+#endif
+
+static
+void shuffle_bytes(uint8_t* dst, const uint8_t* src, size_t nrElements, size_t elmSize)
+{
+    for (size_t b = 0; b < elmSize; ++b) {
+        uint8_t* out = dst + b * nrElements;
+        for (size_t i = 0; i < nrElements; ++i) {
+            out[i] = src[i * elmSize + b];
+        }
+    }
+}
+
+static
+void unshuffle_bytes(uint8_t* dst, const uint8_t* src, size_t nrElements, size_t elmSize)
+{
+    for (size_t b = 0; b < elmSize; ++b) {
+        const uint8_t* in = src + b * nrElements;
+        for (size_t i = 0; i < nrElements; ++i) {
+            dst[i * elmSize + b] = in[i];
+        }
+    }
+}
+
+void numy::tnsr::write_binary_header(uint8_t* out, const numy::Tensor& tensor, uint8_t flags,
+    uint32_t payloadSize)
+{
+    BinaryHeader hdr;
+    hdr.magic       = BinaryHeader::MAGIC;
+    hdr.version     = BinaryHeader::VERSION;
+    hdr.dtype       = tensor.dtype;
+    hdr.flags       = flags | HOST_ENDIAN_FLAG;
+    hdr.nrDims      = tensor.nrDims;
+    hdr.nrElements  = tensor.nrElements;
+    hdr.payloadSize = payloadSize;
+
+    std::memcpy(out, &hdr, sizeof(hdr));
+
+    uint32_t shape[numy::Tensor::MAX_DIMS];
+    for (unsigned i = 0; i < tensor.nrDims; ++i) {
+        shape[i] = tensor.shape[i];
+    }
+    std::memcpy(out + sizeof(hdr), shape, tensor.nrDims * sizeof(uint32_t));
+}
+
+bool numy::tnsr::read_binary_header(const uint8_t* in, size_t size, BinaryHeader& hdr,
+    unsigned shape[numy::Tensor::MAX_DIMS])
+{
+    if (size < sizeof(BinaryHeader)) {
+        return false;
+    }
+
+    std::memcpy(&hdr, in, sizeof(hdr));
+
+    if (hdr.magic != BinaryHeader::MAGIC or hdr.version != BinaryHeader::VERSION or
+        (hdr.flags & BinaryHeader::F_BIG_ENDIAN) != HOST_ENDIAN_FLAG or
+        hdr.dtype != numy::Tensor::T_DBL or
+        hdr.nrDims == 0 or hdr.nrDims >= numy::Tensor::MAX_DIMS or
+        size < binary_header_size(hdr.nrDims))
+    {
+        return false;
+    }
+
+    uint32_t shape32[numy::Tensor::MAX_DIMS];
+    std::memcpy(shape32, in + sizeof(hdr), hdr.nrDims * sizeof(uint32_t));
+
+    // header comes from another node or file, do not trust its sizes
+    uint64_t nrElements {1};
+    for (unsigned i = 0; i < hdr.nrDims; ++i) {
+        shape[i] = shape32[i];
+        nrElements *= shape[i];
+        if (nrElements > numy::tnsr::MAX_ELEMENTS) {
+            return false;
+        }
+    }
+
+    return nrElements != 0 and nrElements == hdr.nrElements;
+}
+
+/**
+ * Encode tensor into binary.
+ *
+ * argv[0] - tensor
+ * argv[1] - compression level 0..9, 0 means no compression
+ */
+ERL_NIF_TERM numy_tensor_encode(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+        return enif_make_badarg(env);
+    }
+
+    int level {0};
+    if (!enif_get_int(env, argv[1], &level) or level < 0 or level > 9) {
+        return enif_make_badarg(env);
+    }
+
+    const size_t hdrSize = binary_header_size(tensor->nrDims);
+
+    if (level == 0) {
+        ERL_NIF_TERM bin;
+        uint8_t* out = enif_make_new_binary(env, hdrSize + tensor->dataSize, &bin);
+        if (out == nullptr) {
+            return enif_make_badarg(env);
+        }
+        write_binary_header(out, *tensor, 0, tensor->dataSize);
+        std::memcpy(out + hdrSize, tensor->data, tensor->dataSize);
+        return bin;
+    }
+
+    const size_t elmSize = sizeof(double);
+
+    uint8_t* shuffled = (uint8_t*) enif_alloc(tensor->dataSize);
+    if (shuffled == nullptr) {
+        return enif_make_badarg(env);
+    }
+    shuffle_bytes(shuffled, (const uint8_t*) tensor->data, tensor->nrElements, elmSize);
+
+    // payload never grows over dataSize, so its size fits 32-bit header,
+    // data that does not compress into that is stored as is
+    uLongf payloadSize = tensor->dataSize;
+
+    ErlNifBinary bin;
+    if (!enif_alloc_binary(hdrSize + payloadSize, &bin)) {
+        enif_free(shuffled);
+        return enif_make_badarg(env);
+    }
+
+    int res = compress2(bin.data + hdrSize, &payloadSize,
+                        shuffled, tensor->dataSize, level);
+
+    enif_free(shuffled);
+
+    if (res == Z_BUF_ERROR) {
+        write_binary_header(bin.data, *tensor, 0, tensor->dataSize);
+        std::memcpy(bin.data + hdrSize, tensor->data, tensor->dataSize);
+        return enif_make_binary(env, &bin);
+    }
+
+    if (res != Z_OK) {
+        enif_release_binary(&bin);
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    write_binary_header(bin.data, *tensor, BinaryHeader::F_COMPRESSED, payloadSize);
+    enif_realloc_binary(&bin, hdrSize + payloadSize);
+
+    return enif_make_binary(env, &bin);
+}
+
+/**
+ * Decode binary made by `numy_tensor_encode` into new tensor.
+ *
+ * argv[0] - binary
+ */
+ERL_NIF_TERM numy_tensor_decode(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return enif_make_badarg(env);
+    }
+
+    ErlNifBinary bin;
+    BinaryHeader hdr;
+    unsigned shape[numy::Tensor::MAX_DIMS];
+
+    if (!enif_inspect_binary(env, argv[0], &bin) or
+        !numy::tnsr::read_binary_header(bin.data, bin.size, hdr, shape))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const size_t hdrSize = binary_header_size(hdr.nrDims);
+
+    if (bin.size != hdrSize + hdr.payloadSize) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifTensor;
+    numy::Tensor* tensor = numy::tnsr::newTensor(env, hdr.nrDims, shape, nifTensor);
+
+    if (tensor == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const uint8_t* payload = bin.data + hdrSize;
+
+    if (!(hdr.flags & BinaryHeader::F_COMPRESSED)) {
+        if (hdr.payloadSize != tensor->dataSize) {
+            return enif_make_badarg(env);
+        }
+        std::memcpy(tensor->data, payload, tensor->dataSize);
+        return nifTensor;
+    }
+
+    uint8_t* shuffled = (uint8_t*) enif_alloc(tensor->dataSize);
+    if (shuffled == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    uLongf dataSize = tensor->dataSize;
+    int res = uncompress(shuffled, &dataSize, payload, hdr.payloadSize);
+
+    if (res == Z_OK and dataSize == tensor->dataSize) {
+        unshuffle_bytes((uint8_t*) tensor->data, shuffled, tensor->nrElements, sizeof(double));
+    }
+
+    enif_free(shuffled);
+
+    return (res == Z_OK and dataSize == tensor->dataSize)?
+        nifTensor : enif_make_badarg(env);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief     Tensor serialization to/from Erlang binary.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <erl_nif.h>
+
+#include "tensor/tensor.hpp"
+
+namespace numy::tnsr {
+
+/**
+ * Header of serialized Tensor, followed by `nrDims` uint32 shape values
+ * and `payloadSize` bytes of payload.
+ *
+ * Payload is raw tensor data unless F_COMPRESSED is set, in which case
+ * it is byte-shuffled data deflated with zlib.
+ */
+struct BinaryHeader
+{
+    static uint32_t constexpr MAGIC = 0x594d554e; // "NUMY" little-endian
+    static uint8_t  constexpr VERSION = 1;
+
+    enum Flags : uint8_t {
+        F_COMPRESSED = 1 << 0,
+        F_BIG_ENDIAN = 1 << 1
+    };
+
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  dtype;
+    uint8_t  flags;
+    uint8_t  nrDims;
+    uint32_t nrElements;
+    uint32_t payloadSize;
+};
+
+static_assert(sizeof(BinaryHeader) == 16, "BinaryHeader must be packed");
+
+/// Size of header followed by `nrDims` shape values.
+static constexpr inline
+size_t binary_header_size(unsigned nrDims) {
+    return sizeof(BinaryHeader) + nrDims * sizeof(uint32_t);
+}
+
+/// Write header and shape of `tensor`, `out` has binary_header_size bytes.
+void write_binary_header(uint8_t* out, const numy::Tensor& tensor, uint8_t flags,
+    uint32_t payloadSize);
+
+/**
+ * Check header and shape at `in` of `size` bytes, `size` must cover header
+ * and shape. Returns false for other magic, version, byte order or dtype,
+ * and for shape that does not match nrElements or is too large.
+ */
+bool read_binary_header(const uint8_t* in, size_t size, BinaryHeader& hdr,
+    unsigned shape[numy::Tensor::MAX_DIMS]);
+
+} // namespace numy::tnsr
+
+ERL_NIF_TERM numy_tensor_encode(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_decode(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
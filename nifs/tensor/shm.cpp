@@ -0,0 +1,344 @@
+/**
+ * @file
+ * @brief     Tensor data in POSIX shared memory.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Several OS processes on the same host (BEAM nodes, C++ programs)
+ * can share one copy of a large read-mostly tensor.
+ * Tensor resource maps the segment and its destructor unmaps it,
+ * the segment itself lives until `numy_tensor_shm_unlink`.
+ */
+#include "tensor/shm.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tensor/nif_resource.hpp"
+
+using numy::tnsr::ShmHeader;
+
+static constexpr size_t DATA_ALIGN = 64; // cache line
+
+static constexpr size_t data_offset() {
+    return (sizeof(ShmHeader) + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+}
+
+/**
+ * Get segment name, prepend '/' if needed as POSIX requires.
+ */
+static
+bool get_shm_name(ErlNifEnv* env, ERL_NIF_TERM term, char name[NAME_MAX])
+{
+    name[0] = '/';
+    if (enif_get_string(env, term, name + 1, NAME_MAX - 1, ERL_NIF_LATIN1) < 2) {
+        return false;
+    }
+    if (name[1] == '/') {
+        std::memmove(name, name + 1, std::strlen(name + 1) + 1);
+    }
+    return std::strchr(name + 1, '/') == nullptr;
+}
+
+static
+bool get_shape(ErlNifEnv* env, ERL_NIF_TERM list, unsigned shape[], unsigned& nrDims)
+{
+    if (!enif_get_list_length(env, list, &nrDims) or
+        nrDims == 0 or nrDims >= numy::Tensor::MAX_DIMS)
+    {
+        return false;
+    }
+
+    int dim;
+    ERL_NIF_TERM head, tail = list;
+
+    for (unsigned i = 0; i < nrDims; ++i) {
+        if (!enif_get_list_cell(env, tail, &head, &tail) or
+            !enif_get_int(env, head, &dim) or dim <= 0)
+        {
+            return false;
+        }
+        shape[i] = dim;
+    }
+
+    return true;
+}
+
+static
+ERL_NIF_TERM make_shm_tensor(ErlNifEnv* env, void* base, size_t mapSize)
+{
+    using namespace numy::tnsr;
+    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
+
+    numy::Tensor* tensor = (resourceMngr == nullptr)? nullptr : resourceMngr->allocate();
+
+    if (tensor == nullptr) {
+        munmap(base, mapSize);
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifTensor = enif_make_resource(env, tensor);
+
+    enif_release_resource(tensor);
+
+    const ShmHeader* hdr = (const ShmHeader*) base;
+
+    tensor->magic      = numy::Tensor::MAGIC;
+    tensor->dtype      = numy::Tensor::T_DBL;
+    tensor->nrDims     = hdr->nrDims;
+    tensor->nrElements = hdr->nrElements;
+    tensor->dataSize   = hdr->dataSize;
+    tensor->storage    = numy::Tensor::S_SHM;
+    tensor->mapBase    = base;
+    tensor->mapSize    = mapSize;
+    tensor->data       = (uint8_t*) base + hdr->dataOffset;
+
+    for (unsigned i = 0; i < hdr->nrDims; ++i) {
+        tensor->shape[i] = hdr->shape[i];
+    }
+
+    return nifTensor;
+}
+
+/**
+ * Map existing segment and validate its header.
+ *
+ * @return mapping base address or nullptr
+ */
+static
+void* map_existing(const char* name, size_t& mapSize)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 or (size_t) st.st_size < data_offset()) {
+        close(fd);
+        return nullptr;
+    }
+
+    mapSize = st.st_size;
+    void* base = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) return nullptr;
+
+    const ShmHeader* hdr = (const ShmHeader*) base;
+
+    uint64_t nrElements = 1;
+    for (unsigned i = 0; i < hdr->nrDims and i < numy::Tensor::MAX_DIMS; ++i) {
+        nrElements *= hdr->shape[i];
+    }
+
+    bool ok = hdr->magic.load(std::memory_order_acquire) == ShmHeader::MAGIC and
+              hdr->version == ShmHeader::VERSION and
+              hdr->dtype == numy::Tensor::T_DBL and
+              hdr->nrDims > 0 and hdr->nrDims < numy::Tensor::MAX_DIMS and
+              nrElements == hdr->nrElements and
+              hdr->dataSize == nrElements * sizeof(double) and
+              hdr->dataOffset + hdr->dataSize <= mapSize;
+
+    if (!ok) {
+        munmap(base, mapSize);
+        return nullptr;
+    }
+
+    return base;
+}
+
+/**
+ * Create named shared memory tensor, or attach to existing one
+ * if it has the same shape.
+ *
+ * argv[0] - segment name
+ * argv[1] - shape
+ */
+ERL_NIF_TERM numy_tensor_shm_create(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    char name[NAME_MAX];
+    unsigned shape[numy::Tensor::MAX_DIMS];
+    unsigned nrDims {0};
+
+    if (argc != 2 or !get_shm_name(env, argv[0], name) or
+        !get_shape(env, argv[1], shape, nrDims))
+    {
+        return enif_make_badarg(env);
+    }
+
+    uint64_t nrElements = 1;
+    for (unsigned i = 0; i < nrDims; ++i) {
+        nrElements *= shape[i];
+    }
+
+    if (nrElements * sizeof(double) > UINT_MAX) {
+        return enif_make_badarg(env);
+    }
+
+    size_t mapSize = data_offset() + nrElements * sizeof(double);
+
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+    if (fd < 0 and errno == EEXIST) {
+        void* base = map_existing(name, mapSize);
+        if (base == nullptr) {
+            return numy::tnsr::getErrAtom(env);
+        }
+        const ShmHeader* hdr = (const ShmHeader*) base;
+        bool sameShape = hdr->nrDims == nrDims and
+            std::memcmp(hdr->shape, shape, nrDims * sizeof(unsigned)) == 0;
+        if (!sameShape) {
+            munmap(base, mapSize);
+            return numy::tnsr::getErrAtom(env);
+        }
+        return make_shm_tensor(env, base, mapSize);
+    }
+
+    if (fd < 0) {
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    void* base = MAP_FAILED;
+
+    if (ftruncate(fd, mapSize) == 0) {
+        base = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        shm_unlink(name);
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    // ftruncate zero-filled the segment, data is all 0.0
+    ShmHeader* hdr = (ShmHeader*) base;
+    hdr->version    = ShmHeader::VERSION;
+    hdr->dtype      = numy::Tensor::T_DBL;
+    hdr->nrDims     = nrDims;
+    hdr->nrElements = nrElements;
+    hdr->dataSize   = nrElements * sizeof(double);
+    hdr->dataOffset = data_offset();
+    hdr->generation.store(0, std::memory_order_relaxed);
+    for (unsigned i = 0; i < nrDims; ++i) {
+        hdr->shape[i] = shape[i];
+    }
+    hdr->magic.store(ShmHeader::MAGIC, std::memory_order_release);
+
+    return make_shm_tensor(env, base, mapSize);
+}
+
+/**
+ * Attach to existing named shared memory tensor.
+ *
+ * argv[0] - segment name
+ */
+ERL_NIF_TERM numy_tensor_shm_attach(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    char name[NAME_MAX];
+
+    if (argc != 1 or !get_shm_name(env, argv[0], name)) {
+        return enif_make_badarg(env);
+    }
+
+    size_t mapSize {0};
+    void* base = map_existing(name, mapSize);
+
+    if (base == nullptr) {
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    return make_shm_tensor(env, base, mapSize);
+}
+
+/**
+ * Remove segment name, memory is released when the last mapping is gone.
+ */
+ERL_NIF_TERM numy_tensor_shm_unlink(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    char name[NAME_MAX];
+
+    if (argc != 1 or !get_shm_name(env, argv[0], name)) {
+        return enif_make_badarg(env);
+    }
+
+    return (shm_unlink(name) == 0)?
+        numy::tnsr::getOkAtom(env) : numy::tnsr::getErrAtom(env);
+}
+
+static
+ShmHeader* get_shm_header(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 1) {
+        return nullptr;
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid() or tensor->storage != numy::Tensor::S_SHM) {
+        return nullptr;
+    }
+
+    return (ShmHeader*) tensor->mapBase;
+}
+
+ERL_NIF_TERM numy_tensor_shm_generation(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    ShmHeader* hdr = get_shm_header(env, argc, argv);
+
+    if (hdr == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    return enif_make_uint64(env, hdr->generation.load(std::memory_order_acquire));
+}
+
+/**
+ * Mark start of data update, generation becomes odd.
+ * Returns error if other writer is in the middle of an update.
+ */
+ERL_NIF_TERM numy_tensor_shm_begin_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    ShmHeader* hdr = get_shm_header(env, argc, argv);
+
+    if (hdr == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    uint64_t gen = hdr->generation.load(std::memory_order_relaxed);
+
+    if ((gen & 1) or !hdr->generation.compare_exchange_strong(gen, gen + 1,
+        std::memory_order_acq_rel))
+    {
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    return enif_make_uint64(env, gen + 1);
+}
+
+/**
+ * Mark end of data update, generation becomes even.
+ */
+ERL_NIF_TERM numy_tensor_shm_end_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    ShmHeader* hdr = get_shm_header(env, argc, argv);
+
+    if (hdr == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    uint64_t gen = hdr->generation.load(std::memory_order_relaxed);
+
+    if (!(gen & 1)) {
+        return numy::tnsr::getErrAtom(env);
+    }
+
+    hdr->generation.store(gen + 1, std::memory_order_release);
+
+    return enif_make_uint64(env, gen + 1);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file
+ * @brief     Tensor data in POSIX shared memory.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Shared memory segment starts with ShmHeader followed by tensor data
+ * at offset `dataOffset`. Layout uses fixed width types only, so
+ * non-BEAM processes on the same host can map the same segment.
+ */
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+#include <erl_nif.h>
+
+#include "tensor/tensor.hpp"
+
+namespace numy::tnsr {
+
+struct ShmHeader
+{
+    static uint64_t constexpr MAGIC = 0x4d48535f594d554eull; // "NUMY_SHM"
+    static uint32_t constexpr VERSION = 1;
+
+    /// Written last by the creator, segment is not ready until it is MAGIC.
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t dtype;
+    uint32_t nrDims;
+    uint32_t shape[Tensor::MAX_DIMS];
+    uint32_t nrElements;
+    uint64_t dataSize;
+    uint64_t dataOffset;
+
+    /**
+     * Generation counter works as seqlock: writer makes it odd before
+     * changing data and even after. Reader that sees the same even
+     * generation before and after reading got consistent data.
+     */
+    std::atomic<uint64_t> generation;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "ShmHeader requires lock-free 64-bit atomics");
+
+} // namespace numy::tnsr
+
+ERL_NIF_TERM numy_tensor_shm_create(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shm_attach(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shm_unlink(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shm_generation(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shm_begin_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_shm_end_update(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
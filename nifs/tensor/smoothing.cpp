@@ -0,0 +1,217 @@
+/**
+ * @file
+ * @brief     Exponential smoothing.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Each row (run of shape[0] elements) is one series, so tensor
+ * [len, n] is a batch of n series advanced by len samples in one call.
+ * Series are independent and split between threads.
+ *
+ * Final state is returned as tensor [2, n], pair per series, pass it
+ * back with the next batch to continue without history.
+ *
+ * EWMA/EWMV, incremental form:
+ *   d = x - mean, mean += α d, var = (1 - α)(var + α d²)
+ *
+ * Holt linear trend:
+ *   level' = α x + (1 - α)(level + trend)
+ *   trend' = β (level' - level) + (1 - β) trend
+ */
+#include "tensor/smoothing.hpp"
+
+#include <algorithm>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+/**
+ * Get state tensor [2, rows] or nil.
+ * Returns false on bad argument, state is nullptr for nil.
+ */
+bool get_state(ErlNifEnv* env, ERL_NIF_TERM term, size_t rows, const double*& state)
+{
+    state = nullptr;
+    if (enif_is_atom(env, term)) return true;
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, term);
+    if (tensor == nullptr or !tensor->isValid() or tensor->nrElements != 2 * rows) {
+        return false;
+    }
+    state = (const double*) tensor->data;
+    return true;
+}
+
+} // anonymous namespace
+
+/**
+ * Exponentially weighted moving average and variance.
+ *
+ * argv[0] - tensor, rows are series
+ * argv[1] - alpha, 0 < α <= 1, weight of new sample
+ * argv[2] - state from previous call or nil,
+ *           without state series start at first sample with variance 0
+ *
+ * Returns {mean, var, state}, mean and var are tensors of input shape,
+ * state is [2, n] tensor of (mean, var) per series.
+ */
+ERL_NIF_TERM numy_tensor_ewm(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 3) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    double alpha {0.0};
+    if (tensor == nullptr or !tensor->isValid() or
+        !numy::tnsr::getNumber(env, argv[1], alpha) or !(alpha > 0.0 and alpha <= 1.0))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const size_t len = tensor->shape[0];
+    const size_t rows = tensor->nrElements / len;
+
+    const double* state {nullptr};
+    if (!get_state(env, argv[2], rows, state)) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifMean, nifVar, nifState;
+    numy::Tensor* mean = numy::tnsr::newTensor(env, tensor->nrDims, tensor->shape, nifMean);
+    if (mean == nullptr) {
+        return enif_make_badarg(env);
+    }
+    numy::Tensor* var = numy::tnsr::newTensor(env, tensor->nrDims, tensor->shape, nifVar);
+    if (var == nullptr) {
+        return enif_make_badarg(env);
+    }
+    unsigned stateShape[2] = {2, (unsigned) rows};
+    numy::Tensor* newState = numy::tnsr::newTensor(env, 2, stateShape, nifState);
+    if (newState == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* in = (const double*) tensor->data;
+    double* m = mean->dbl_data();
+    double* v = var->dbl_data();
+    double* st = newState->dbl_data();
+
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+
+    numy::par::parallel_for(rows, minChunk, [=](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* x = in + r * len;
+            double* mr = m + r * len;
+            double* vr = v + r * len;
+
+            double mu = (state != nullptr)? state[2 * r] : x[0];
+            double s2 = (state != nullptr)? state[2 * r + 1] : 0.0;
+
+            for (size_t i = 0; i < len; ++i) {
+                const double d = x[i] - mu;
+                const double incr = alpha * d;
+                mu += incr;
+                s2 = (1.0 - alpha) * (s2 + d * incr);
+                mr[i] = mu;
+                vr[i] = s2;
+            }
+
+            st[2 * r] = mu;
+            st[2 * r + 1] = s2;
+        }
+    });
+
+    return enif_make_tuple3(env, nifMean, nifVar, nifState);
+}
+
+/**
+ * Holt double exponential smoothing.
+ *
+ * argv[0] - tensor, rows are series
+ * argv[1] - alpha, 0 < α <= 1, level smoothing
+ * argv[2] - beta, 0 <= β <= 1, trend smoothing
+ * argv[3] - state from previous call or nil, without state level
+ *           starts at first sample and trend at second minus first
+ *
+ * Returns {level, state}, level is tensor of input shape,
+ * state is [2, n] tensor of (level, trend) per series;
+ * forecast h steps ahead is level + h·trend.
+ */
+ERL_NIF_TERM numy_tensor_holt(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 4) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    double alpha {0.0}, beta {0.0};
+    if (tensor == nullptr or !tensor->isValid() or
+        !numy::tnsr::getNumber(env, argv[1], alpha) or !(alpha > 0.0 and alpha <= 1.0) or
+        !numy::tnsr::getNumber(env, argv[2], beta) or !(beta >= 0.0 and beta <= 1.0))
+    {
+        return enif_make_badarg(env);
+    }
+
+    const size_t len = tensor->shape[0];
+    const size_t rows = tensor->nrElements / len;
+
+    const double* state {nullptr};
+    if (!get_state(env, argv[3], rows, state)) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifLevel, nifState;
+    numy::Tensor* level = numy::tnsr::newTensor(env, tensor->nrDims, tensor->shape, nifLevel);
+    if (level == nullptr) {
+        return enif_make_badarg(env);
+    }
+    unsigned stateShape[2] = {2, (unsigned) rows};
+    numy::Tensor* newState = numy::tnsr::newTensor(env, 2, stateShape, nifState);
+    if (newState == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* in = (const double*) tensor->data;
+    double* lv = level->dbl_data();
+    double* st = newState->dbl_data();
+
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / len);
+
+    numy::par::parallel_for(rows, minChunk, [=](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; ++r) {
+            const double* x = in + r * len;
+            double* out = lv + r * len;
+
+            double l, b;
+            size_t i {0};
+            if (state != nullptr) {
+                l = state[2 * r];
+                b = state[2 * r + 1];
+            }
+            else {
+                l = x[0];
+                b = (len > 1)? x[1] - x[0] : 0.0;
+                out[0] = l;
+                i = 1;
+            }
+
+            for (; i < len; ++i) {
+                const double prev = l;
+                l = alpha * x[i] + (1.0 - alpha) * (l + b);
+                b = beta * (l - prev) + (1.0 - beta) * b;
+                out[i] = l;
+            }
+
+            st[2 * r] = l;
+            st[2 * r + 1] = b;
+        }
+    });
+
+    return enif_make_tuple2(env, nifLevel, nifState);
+}
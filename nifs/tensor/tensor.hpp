@@ -9,6 +9,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 namespace numy {
 
@@ -29,11 +30,24 @@ struct Tensor
     unsigned nrElements;
     unsigned dataSize; /// size of data in bytes
 
+    /// where `data` comes from and how to release it,
+    /// S_VIEW data belongs to other tensor resource that view keeps alive
+    enum Storage {S_HEAP, S_SHM, S_VIEW} storage = S_HEAP;
+
+    void* mapBase = nullptr; ///< start of shared memory mapping (S_SHM), owner tensor (S_VIEW)
+    size_t mapSize = 0;      ///< size of shared memory mapping, S_SHM only
+
     inline bool isValid() const {
         return nrDims > 0 and nrDims < MAX_DIMS and
                magic == MAGIC and data != nullptr;
     }
 
+    /// Do data of two tensors share any byte, views share data of their owner.
+    inline bool overlaps(const Tensor& other) const {
+        const uintptr_t a = (uintptr_t) data, b = (uintptr_t) other.data;
+        return a < b + other.dataSize and b < a + dataSize;
+    }
+
     inline unsigned nr_cols() const {
         return shape[0];
     }
@@ -0,0 +1,235 @@
+/**
+ * @file
+ * @brief     Transpose, permute and reshape tensor axes.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Tensor data is always dense row-major, so reshape only changes
+ * shape, data is not touched.
+ *
+ * Permutation copies data into new tensor:
+ *
+ * - permutation that keeps axis 0 copies contiguous runs of shape[0]
+ * - swap of two groups of axes, like 2-D transpose or [1, 0, 2]
+ *   batch of transposes, is cache-blocked: TILE×TILE tile is read
+ *   row by row and written column by column while both fit in L1,
+ *   instead of striding over whole matrix for every element;
+ *   tile rows are split between threads
+ * - any other permutation walks output with odometer
+ */
+#include "tensor/transpose.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+#include "tensor/tensor.hpp"
+#include "tensor/nif_resource.hpp"
+#include "tensor/parallel.hpp"
+
+namespace {
+
+constexpr size_t TILE = 32;
+
+/**
+ * Transpose row-major rows×cols matrix `in` into cols×rows `out`.
+ */
+void transpose_blocked(const double* in, double* out, size_t rows, size_t cols)
+{
+    const size_t nrTileRows = (rows + TILE - 1) / TILE;
+    const size_t minChunk = std::max<size_t>(1, numy::par::MIN_ELEMENTS / (TILE * cols));
+
+    numy::par::parallel_for(nrTileRows, minChunk, [=](size_t begin, size_t end, unsigned) {
+        for (size_t ti = begin; ti < end; ++ti) {
+            const size_t i0 = ti * TILE, i1 = std::min(rows, i0 + TILE);
+            for (size_t j0 = 0; j0 < cols; j0 += TILE) {
+                const size_t j1 = std::min(cols, j0 + TILE);
+                for (size_t i = i0; i < i1; ++i) {
+                    const double* src = in + i * cols;
+                    for (size_t j = j0; j < j1; ++j) {
+                        out[j * rows + i] = src[j];
+                    }
+                }
+            }
+        }
+    });
+}
+
+/**
+ * Permutation [k, .., nd0-1, 0, .., k-1, nd0, .., nd-1] swaps groups
+ * of axes [0, k) and [k, nd0), return k and set nd0, else return 0.
+ */
+unsigned group_swap(const unsigned perm[], unsigned nd, unsigned& nd0)
+{
+    const unsigned k = perm[0];
+    if (k == 0) return 0;
+
+    unsigned i = 1;
+    while (i < nd and perm[i] == k + i) ++i;
+    nd0 = k + i;
+
+    for (unsigned a = 0; a < k; ++a, ++i) {
+        if (i >= nd or perm[i] != a) return 0;
+    }
+    for (; i < nd; ++i) {
+        if (perm[i] != i) return 0;
+    }
+    return k;
+}
+
+} // anonymous namespace
+
+/**
+ * Permute tensor axes, output shape[i] is input shape[perm[i]].
+ *
+ * argv[0] - tensor
+ * argv[1] - permutation, list of nrDims axis indexes,
+ *           [1, 0] is matrix transpose
+ *
+ * Returns new tensor.
+ */
+ERL_NIF_TERM numy_tensor_permute(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    const numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned nd = tensor->nrDims;
+
+    unsigned perm[numy::Tensor::MAX_DIMS];
+    bool used[numy::Tensor::MAX_DIMS] = {false};
+    unsigned len {0};
+
+    ERL_NIF_TERM head, tail, list = argv[1];
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        unsigned axis;
+        if (len == nd or !enif_get_uint(env, head, &axis) or axis >= nd or used[axis]) {
+            return enif_make_badarg(env);
+        }
+        used[axis] = true;
+        perm[len++] = axis;
+        list = tail;
+    }
+
+    if (len != nd) {
+        return enif_make_badarg(env);
+    }
+
+    unsigned outShape[numy::Tensor::MAX_DIMS];
+    for (unsigned i = 0; i < nd; ++i) {
+        outShape[i] = tensor->shape[perm[i]];
+    }
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, nd, outShape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const double* in = (const double*) tensor->data;
+    double* dst = out->dbl_data();
+    const size_t n = tensor->nrElements;
+
+    unsigned nd0 {0};
+    const unsigned k = group_swap(perm, nd, nd0);
+
+    if (k != 0) {
+        // batch of (rows = axes [k, nd0)) × (cols = axes [0, k)) transposes
+        size_t cols {1}, rows {1};
+        for (unsigned a = 0; a < k; ++a) cols *= tensor->shape[a];
+        for (unsigned a = k; a < nd0; ++a) rows *= tensor->shape[a];
+        const size_t block = rows * cols;
+        for (size_t off = 0; off < n; off += block) {
+            transpose_blocked(in + off, dst + off, rows, cols);
+        }
+        return nifOut;
+    }
+
+    // input strides
+    size_t stride[numy::Tensor::MAX_DIMS];
+    stride[0] = 1;
+    for (unsigned i = 1; i < nd; ++i) {
+        stride[i] = stride[i - 1] * tensor->shape[i - 1];
+    }
+
+    // odometer over output, innermost output axis is a run
+    const size_t run = outShape[0];
+    const size_t runStride = stride[perm[0]];
+    unsigned idx[numy::Tensor::MAX_DIMS] = {0};
+    size_t srcOff {0};
+
+    for (size_t off = 0; off < n; off += run)
+    {
+        if (runStride == 1) {
+            std::memcpy(dst + off, in + srcOff, sizeof(double) * run);
+        }
+        else {
+            for (size_t r = 0; r < run; ++r) {
+                dst[off + r] = in[srcOff + r * runStride];
+            }
+        }
+
+        for (unsigned d = 1; d < nd; ++d) {
+            srcOff += stride[perm[d]];
+            if (++idx[d] < outShape[d]) break;
+            srcOff -= stride[perm[d]] * outShape[d];
+            idx[d] = 0;
+        }
+    }
+
+    return nifOut;
+}
+
+/**
+ * Reshape tensor, data is not moved.
+ *
+ * argv[0] - tensor
+ * argv[1] - new shape, list with same product of dimensions
+ *
+ * Returns new tensor resource sharing data with argv[0], shape
+ * of argv[0] is not changed.
+ */
+ERL_NIF_TERM numy_tensor_reshape(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    if (argc != 2) {
+        return enif_make_badarg(env);
+    }
+
+    numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+        return enif_make_badarg(env);
+    }
+
+    unsigned shape[numy::Tensor::MAX_DIMS];
+    unsigned nd {0};
+    size_t product {1};
+
+    ERL_NIF_TERM head, tail, list = argv[1];
+    while (enif_get_list_cell(env, list, &head, &tail)) {
+        if (nd + 1 == numy::Tensor::MAX_DIMS or !enif_get_uint(env, head, &shape[nd]) or
+            shape[nd] == 0)
+        {
+            return enif_make_badarg(env);
+        }
+        product *= shape[nd++];
+        list = tail;
+    }
+
+    if (nd == 0 or product != tensor->nrElements) {
+        return enif_make_badarg(env);
+    }
+
+    ERL_NIF_TERM nifOut;
+    if (numy::tnsr::newTensorView(env, tensor, nd, shape, nifOut) == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    return nifOut;
+}
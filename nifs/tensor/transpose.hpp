@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief     Transpose, permute and reshape tensor axes.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ */
+#pragma once
+
+#include <erl_nif.h>
+
+ERL_NIF_TERM numy_tensor_permute(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
+ERL_NIF_TERM numy_tensor_reshape(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]);
@@ -15,9 +15,13 @@
 #include <cstring>
 
 #include <erl_nif.h>
+#include <cblas.h>
 
 #include "tensor/tensor.hpp"
 #include "tensor/nif_resource.hpp"
+#include "tensor/broadcast.hpp"
+#include "tensor/vmath.hpp"
+#include "tensor/serialize.hpp"
 
 #include "float_almost_equals.hpp"
 
@@ -26,11 +30,7 @@
 static inline
 double dot_vectors(const double a[], const double b[], unsigned length)
 {
-    double result = 0.0;
-    for (unsigned int i = 0; i < length; ++i) {
-        result += a[i] * b[i];
-    }
-    return result;
+    return cblas_ddot(length, a, 1, b, 1);
 }
 
 static inline
@@ -176,25 +176,15 @@ void pow2_vector(double a[], unsigned length)
 }
 
 static inline
-void pow_vector(double a[], unsigned length, double p)
+void pow_vector(double a[], unsigned length, double p, numy::vmath::Accuracy acc)
 {
-    #pragma GCC ivdep
-    for (unsigned int i = 0; i < length; ++i) {
-        a[i] = std::pow(a[i], p);
-    }
+    numy::vmath::pow(a, a, length, p, acc);
 }
 
 static inline
 double vector_norm2(double a[], unsigned length)
 {
-    double norm {0.0};
-
-    #pragma GCC ivdep
-    for (unsigned int i = 0; i < length; ++i) {
-        norm += a[i] * a[i];
-    }
-
-    return std::sqrt(norm);
+    return cblas_dnrm2(length, a, 1);
 }
 
 static inline
@@ -270,39 +260,95 @@ void vector_setop(double a[], unsigned len_a,
     v.resize(it - v.begin());
 }
 
-bool tensor_save_to_file(numy::Tensor& tensor, const char* filename)
+/**
+ * Save tensor to file: serialization header (tensor/serialize.hpp)
+ * and raw data, same bytes as uncompressed `tensor_encode` binary.
+ */
+bool tensor_save_to_file(const numy::Tensor& tensor, const char* filename)
 {
     FILE* f = std::fopen(filename, "w");
     if (f == nullptr) return false;
 
-    size_t hsz = std::fwrite(&tensor , sizeof(tensor), 1, f);
+    uint8_t hdr[numy::tnsr::binary_header_size(numy::Tensor::MAX_DIMS)];
+    const size_t hdrSize = numy::tnsr::binary_header_size(tensor.nrDims);
+    numy::tnsr::write_binary_header(hdr, tensor, 0, tensor.dataSize);
+
+    size_t hsz = std::fwrite(hdr, 1, hdrSize, f);
     size_t dsz = std::fwrite(tensor.data, 1, tensor.dataSize, f);
 
     std::fclose(f);
 
-    return hsz == 1 and dsz == tensor.dataSize;
+    return hsz == hdrSize and dsz == tensor.dataSize;
 }
 
-bool tensor_load_from_file(numy::Tensor& tensor, const char* filename)
+/**
+ * Header of files saved by older versions: raw Tensor struct of that time,
+ * magic, dtype, nrDims, shape, data pointer, nrElements, dataSize.
+ */
+struct LegacyFileHeader
 {
-    FILE* f = std::fopen(filename, "r");
-    if (f == nullptr) return false;
-
-    size_t hsz = std::fread(&tensor , sizeof(tensor), 1, f);
+    uint64_t magic;
+    uint32_t dtype;
+    uint32_t nrDims;
+    uint32_t shape[numy::Tensor::MAX_DIMS];
+    uint64_t data;
+    uint32_t nrElements;
+    uint32_t dataSize;
+};
 
-    bool header_ok = hsz == 1 and tensor.magic == tensor.MAGIC;
+static_assert(sizeof(LegacyFileHeader) == 160, "LegacyFileHeader must match old Tensor");
 
-    bool data_ok {false};
+/**
+ * Read and check header of file saved by `tensor_save_to_file`,
+ * or by older versions that wrote raw Tensor struct (Tensor::MAGIC).
+ * Returns false for files of other format.
+ */
+static
+bool tensor_read_file_header(FILE* f, numy::tnsr::BinaryHeader& hdr,
+    unsigned shape[numy::Tensor::MAX_DIMS])
+{
+    uint8_t buf[numy::tnsr::binary_header_size(numy::Tensor::MAX_DIMS)];
+
+    // fixed part tells format and how many shape values follow
+    if (std::fread(buf, 1, sizeof(hdr), f) != sizeof(hdr)) return false;
+    std::memcpy(&hdr, buf, sizeof(hdr));
+
+    uint64_t magic;
+    std::memcpy(&magic, buf, sizeof(magic));
+
+    if (magic == numy::Tensor::MAGIC) {
+        LegacyFileHeader old;
+        std::memcpy(&old, buf, sizeof(hdr));
+        const size_t rest = sizeof(old) - sizeof(hdr);
+        if (std::fread((uint8_t*) &old + sizeof(hdr), 1, rest, f) != rest or
+            old.nrDims == 0 or old.nrDims >= numy::Tensor::MAX_DIMS)
+        {
+            return false;
+        }
 
-    if (header_ok and tensor.nrElements > 0 and tensor.dataSize > 0) {
-        tensor.data = enif_alloc(tensor.dataSize);
-        size_t dsz = std::fread(tensor.data, 1, tensor.dataSize, f);
-        data_ok = (dsz == tensor.dataSize);
+        // checked below same way as current header
+        numy::Tensor tensor;
+        tensor.dtype = (old.dtype == numy::Tensor::T_DBL)?
+            numy::Tensor::T_DBL : numy::Tensor::T_FLT;
+        tensor.nrDims = old.nrDims;
+        tensor.nrElements = old.nrElements;
+        std::copy(old.shape, old.shape + old.nrDims, tensor.shape);
+        numy::tnsr::write_binary_header(buf, tensor, 0, old.dataSize);
+        std::memcpy(&hdr, buf, sizeof(hdr));
+    }
+    else {
+        if (hdr.magic != numy::tnsr::BinaryHeader::MAGIC or hdr.nrDims >= numy::Tensor::MAX_DIMS) {
+            return false;
+        }
+        const size_t shapeSize = hdr.nrDims * sizeof(uint32_t);
+        if (std::fread(buf + sizeof(hdr), 1, shapeSize, f) != shapeSize) return false;
     }
 
-    std::fclose(f);
+    const size_t hdrSize = numy::tnsr::binary_header_size(hdr.nrDims);
 
-    return header_ok and data_ok;
+    return numy::tnsr::read_binary_header(buf, hdrSize, hdr, shape) and
+        !(hdr.flags & numy::tnsr::BinaryHeader::F_COMPRESSED) and
+        hdr.payloadSize == hdr.nrElements * sizeof(double);
 }
 
 /**
@@ -378,6 +424,40 @@ bool vector_fnum_argv(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[],
     return true;
 }
 
+/// Accuracy atom, :accurate or :fast.
+static inline
+bool get_accuracy(ErlNifEnv* env, ERL_NIF_TERM term, numy::vmath::Accuracy& acc)
+{
+    char atom[16];
+    if (!enif_get_atom(env, term, atom, sizeof(atom), ERL_NIF_LATIN1)) {
+        return false;
+    }
+
+    if (0 == strcmp(atom, "accurate")) acc = numy::vmath::Accuracy::ULP1;
+    else if (0 == strcmp(atom, "fast")) acc = numy::vmath::Accuracy::FAST;
+    else return false;
+
+    return true;
+}
+
+/// Tensor and accuracy atom, :accurate or :fast.
+static inline
+bool vector_accuracy_argv(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[],
+    numy::Tensor*& tensor, numy::vmath::Accuracy& acc)
+{
+    if (argc != 2) {
+        return false;
+    }
+
+    tensor = numy::tnsr::getTensor(env, argv[0]);
+
+    if (tensor == nullptr or !tensor->isValid()) {
+	    return false;
+    }
+
+    return get_accuracy(env, argv[1], acc);
+}
+
 ERL_NIF_TERM numy_vector_dot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
     numy::Tensor* tensor1 {nullptr};
@@ -395,11 +475,70 @@ ERL_NIF_TERM numy_vector_dot(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]
     return retVal;
 }
 
-using VectorFunOP2 = void (*)(double a[], const double b[], unsigned length);
+static inline
+void add_scalar(double a[], double b, unsigned length)
+{
+    #pragma GCC ivdep
+    for (unsigned int i = 0; i < length; ++i) {
+        a[i] += b;
+    }
+}
 
-static
-ERL_NIF_TERM numy_vector__op2(ErlNifEnv* env, int argc,
-    const ERL_NIF_TERM argv[], VectorFunOP2 op)
+static inline
+void sub_scalar(double a[], double b, unsigned length)
+{
+    #pragma GCC ivdep
+    for (unsigned int i = 0; i < length; ++i) {
+        a[i] -= b;
+    }
+}
+
+static inline
+void mul_scalar(double a[], double b, unsigned length)
+{
+    #pragma GCC ivdep
+    for (unsigned int i = 0; i < length; ++i) {
+        a[i] *= b;
+    }
+}
+
+static inline
+void div_scalar(double a[], double b, unsigned length)
+{
+    #pragma GCC ivdep
+    for (unsigned int i = 0; i < length; ++i) {
+        a[i] /= b;
+    }
+}
+
+struct AddOp {
+    static void vec(double a[], const double b[], unsigned n) { add_vectors(a, b, n); }
+    static void scalar(double a[], double b, unsigned n) { add_scalar(a, b, n); }
+};
+
+struct SubOp {
+    static void vec(double a[], const double b[], unsigned n) { sub_vectors(a, b, n); }
+    static void scalar(double a[], double b, unsigned n) { sub_scalar(a, b, n); }
+};
+
+struct MulOp {
+    static void vec(double a[], const double b[], unsigned n) { mul_vectors(a, b, n); }
+    static void scalar(double a[], double b, unsigned n) { mul_scalar(a, b, n); }
+};
+
+struct DivOp {
+    static void vec(double a[], const double b[], unsigned n) { div_vectors(a, b, n); }
+    static void scalar(double a[], double b, unsigned n) { div_scalar(a, b, n); }
+};
+
+/**
+ * In-place A op= B.
+ *
+ * Tensors with the same number of elements are processed as flat arrays,
+ * otherwise B is broadcast to shape of A, see broadcast.hpp.
+ */
+template<class Op>
+ERL_NIF_TERM numy_vector__op2(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
     numy::Tensor* tensor1 {nullptr};
     numy::Tensor* tensor2 {nullptr};
@@ -408,27 +547,31 @@ ERL_NIF_TERM numy_vector__op2(ErlNifEnv* env, int argc,
         return enif_make_badarg(env);
     }
 
-    unsigned int length = std::min(tensor1->nrElements, tensor2->nrElements);
+    if (tensor1->nrElements != tensor2->nrElements and
+        !numy::tnsr::broadcastable(*tensor1, *tensor2))
+    {
+        return enif_make_badarg(env);
+    }
 
-    op(tensor1->dbl_data(), tensor2->dbl_data(), length);
+    numy::tnsr::broadcast_op2<Op>(*tensor1, *tensor2);
 
     return numy::tnsr::getOkAtom(env);
 }
 
 ERL_NIF_TERM numy_vector_add(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]) {
-    return numy_vector__op2(env, argc, argv, add_vectors);
+    return numy_vector__op2<AddOp>(env, argc, argv);
 }
 
 ERL_NIF_TERM numy_vector_sub(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]) {
-    return numy_vector__op2(env, argc, argv, sub_vectors);
+    return numy_vector__op2<SubOp>(env, argc, argv);
 }
 
 ERL_NIF_TERM numy_vector_mul(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]) {
-    return numy_vector__op2(env, argc, argv, mul_vectors);
+    return numy_vector__op2<MulOp>(env, argc, argv);
 }
 
 ERL_NIF_TERM numy_vector_div(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]) {
-    return numy_vector__op2(env, argc, argv, div_vectors);
+    return numy_vector__op2<DivOp>(env, argc, argv);
 }
 
 ERL_NIF_TERM numy_vector_get_at(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
@@ -558,12 +701,7 @@ ERL_NIF_TERM numy_vector_scale(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv
         return enif_make_badarg(env);
     }
 
-    double* data = tensor->dbl_data();
-
-    #pragma GCC ivdep
-    for (unsigned i = 0; i < tensor->nrElements; ++i) {
-        data[i] *= factor;
-    }
+    cblas_dscal(tensor->nrElements, factor, tensor->dbl_data(), 1);
 
     return numy::tnsr::getOkAtom(env);
 }
@@ -716,26 +854,118 @@ ERL_NIF_TERM numy_vector_heaviside(ErlNifEnv* env, int argc, const ERL_NIF_TERM
 
 ERL_NIF_TERM numy_vector_sigmoid(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-    if (argc != 1) {
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc)) {
         return enif_make_badarg(env);
     }
 
-    numy::Tensor* tensor = numy::tnsr::getTensor(env, argv[0]);
+    numy::vmath::sigmoid(tensor->dbl_data(), tensor->dbl_data(), tensor->nrElements, acc);
 
-    if (tensor == nullptr or !tensor->isValid()) {
-	    return enif_make_badarg(env);
+    return numy::tnsr::getOkAtom(env);
+}
+
+ERL_NIF_TERM numy_vector_exp(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc)) {
+        return enif_make_badarg(env);
+    }
+
+    numy::vmath::exp(tensor->dbl_data(), tensor->dbl_data(), tensor->nrElements, acc);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+ERL_NIF_TERM numy_vector_log(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc)) {
+        return enif_make_badarg(env);
     }
 
+    numy::vmath::log(tensor->dbl_data(), tensor->dbl_data(), tensor->nrElements, acc);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+ERL_NIF_TERM numy_vector_tanh(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc)) {
+        return enif_make_badarg(env);
+    }
+
+    numy::vmath::tanh(tensor->dbl_data(), tensor->dbl_data(), tensor->nrElements, acc);
+
+    return numy::tnsr::getOkAtom(env);
+}
+
+/**
+ * In-place softmax of each row, rows are runs of shape[0] elements.
+ */
+ERL_NIF_TERM numy_vector_softmax(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc) or tensor->nrElements == 0) {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned len = tensor->shape[0];
     double* x = tensor->dbl_data();
 
-    #pragma GCC ivdep
-    for (unsigned i = 0; i < tensor->nrElements; ++i) {
-        x[i] = 1.0 / (1.0 + exp(-x[i]));
+    for (unsigned off = 0; off < tensor->nrElements; off += len) {
+        numy::vmath::softmax(x + off, len, acc);
     }
 
     return numy::tnsr::getOkAtom(env);
 }
 
+/**
+ * log(sum(exp(row))) of each row, rows are runs of shape[0] elements.
+ *
+ * Returns new tensor of shape without axis 0, [1] for 1-D tensor.
+ */
+ERL_NIF_TERM numy_vector_logsumexp(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
+{
+    numy::Tensor* tensor {nullptr};
+    numy::vmath::Accuracy acc;
+
+    if (!vector_accuracy_argv(env, argc, argv, tensor, acc) or tensor->nrElements == 0) {
+        return enif_make_badarg(env);
+    }
+
+    unsigned outShape[numy::Tensor::MAX_DIMS] = {1};
+    const unsigned outDims = std::max(1u, tensor->nrDims - 1);
+    std::copy(tensor->shape + 1, tensor->shape + tensor->nrDims, outShape);
+
+    ERL_NIF_TERM nifOut;
+    numy::Tensor* out = numy::tnsr::newTensor(env, outDims, outShape, nifOut);
+
+    if (out == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    const unsigned len = tensor->shape[0];
+    const double* x = tensor->dbl_data();
+    double* y = out->dbl_data();
+
+    for (unsigned row = 0; row < out->nrElements; ++row) {
+        y[row] = numy::vmath::logsumexp(x + row * len, len, acc);
+    }
+
+    return nifOut;
+}
+
 ERL_NIF_TERM numy_vector_sort(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
     if (argc != 1) {
@@ -978,9 +1208,17 @@ ERL_NIF_TERM numy_vector_pow2(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[
     return numy::tnsr::getOkAtom(env);
 }
 
+/**
+ * Raise to power p in place.
+ *
+ * argv[0] - tensor
+ * argv[1] - p
+ * argv[2] - accuracy, :accurate or :fast; :fast vectorizes
+ *           all powers, :accurate only small integers and 0.5
+ */
 ERL_NIF_TERM numy_vector_pow(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[])
 {
-    if (argc != 2) {
+    if (argc != 3) {
         return enif_make_badarg(env);
     }
 
@@ -998,7 +1236,12 @@ ERL_NIF_TERM numy_vector_pow(ErlNifEnv* env, int argc, const ERL_NIF_TERM argv[]
         p = i;
     }
 
-    pow_vector(tensor->dbl_data(), tensor->nrElements, p);
+    numy::vmath::Accuracy acc;
+    if (!get_accuracy(env, argv[2], acc)) {
+        return enif_make_badarg(env);
+    }
+
+    pow_vector(tensor->dbl_data(), tensor->nrElements, p, acc);
 
     return numy::tnsr::getOkAtom(env);
 }
@@ -1082,22 +1325,27 @@ ERL_NIF_TERM numy_tensor_load_from_file(ErlNifEnv* env, int argc, const ERL_NIF_
         return enif_make_badarg(env);
     }
 
-    using namespace numy::tnsr;
-    NIFResource* resourceMngr = (NIFResource*) enif_priv_data(env);
-
-    if (resourceMngr == nullptr)
-        return enif_make_badarg(env);
+    FILE* f = std::fopen(filename, "r");
+    if (f == nullptr) {
+        return numy::tnsr::getErrAtom(env);
+    }
 
-    numy::Tensor* tensor = resourceMngr->allocate();
+    numy::tnsr::BinaryHeader hdr;
+    unsigned shape[numy::Tensor::MAX_DIMS];
 
-    if (tensor == nullptr)
-        return enif_make_badarg(env);
+    if (!tensor_read_file_header(f, hdr, shape)) {
+        std::fclose(f);
+        return enif_make_tuple2(env, numy::tnsr::getErrAtom(env),
+            enif_make_atom(env, "unsupported_format"));
+    }
 
-    ERL_NIF_TERM nifTensor = enif_make_resource(env, tensor);
+    ERL_NIF_TERM nifTensor;
+    numy::Tensor* tensor = numy::tnsr::newTensor(env, hdr.nrDims, shape, nifTensor);
 
-    enif_release_resource(tensor);
+    bool ok = tensor != nullptr and
+        std::fread(tensor->data, 1, tensor->dataSize, f) == tensor->dataSize;
 
-    bool ok = tensor_load_from_file(*tensor, filename);
+    std::fclose(f);
 
     return ok ? nifTensor : numy::tnsr::getErrAtom(env);
 }
\ No newline at end of file
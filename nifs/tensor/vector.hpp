@@ -36,6 +36,11 @@ DECL_NIF(numy_vector_pow)
 DECL_NIF(numy_vector_norm2)
 DECL_NIF(numy_vector_heaviside)
 DECL_NIF(numy_vector_sigmoid)
+DECL_NIF(numy_vector_exp)
+DECL_NIF(numy_vector_log)
+DECL_NIF(numy_vector_tanh)
+DECL_NIF(numy_vector_softmax)
+DECL_NIF(numy_vector_logsumexp)
 DECL_NIF(numy_vector_sort)
 DECL_NIF(numy_vector_reverse)
 DECL_NIF(numy_vector_axpby)
@@ -0,0 +1,207 @@
+/**
+ * @file
+ * @brief     Vectorizable exp, log, tanh, sigmoid, pow over arrays.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * Baseline x86-64 has only 2-wide SSE2 without FMA, there the
+ * polynomials are no faster than libm. On x86-64 loops are compiled
+ * twice, for x86-64-v3 (AVX2, FMA) and for the baseline, and the
+ * loader picks the clone that the CPU supports.
+ *
+ * Vectorizing selects needs -fno-trapping-math, otherwise the compiler
+ * must keep the branches in case arithmetic raises FP exceptions.
+ */
+#include "tensor/vmath.hpp"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define NUMY_VMATH_CLONES __attribute__((target_clones("arch=x86-64-v3", "default")))
+#else
+#define NUMY_VMATH_CLONES
+#endif
+
+namespace numy::vmath {
+
+namespace {
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+void exp_loop(const double* in, double* out, size_t n)
+{
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = exp<A>(in[i]);
+}
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+void log_loop(const double* in, double* out, size_t n)
+{
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = log<A>(in[i]);
+}
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+void sigmoid_loop(const double* in, double* out, size_t n)
+{
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = sigmoid<A>(in[i]);
+}
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+void tanh_loop(const double* in, double* out, size_t n)
+{
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = tanh<A>(in[i]);
+}
+
+NUMY_VMATH_CLONES
+void pow_fast_loop(const double* in, double* out, size_t n, double p)
+{
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) out[i] = pow_exp_log<Accuracy::FAST>(in[i], p);
+}
+
+/// Integer power k by repeated squaring, bit by bit over a block.
+NUMY_VMATH_CLONES
+void pow_int_loop(const double* in, double* out, size_t n, unsigned k, bool invert)
+{
+    constexpr size_t BLOCK = 256;
+    double base[BLOCK], acc[BLOCK];
+
+    for (size_t off = 0; off < n; off += BLOCK)
+    {
+        const size_t len = std::min(BLOCK, n - off);
+        for (size_t i = 0; i < len; ++i) {
+            base[i] = in[off + i];
+            acc[i] = 1.0;
+        }
+        for (unsigned b = k; b != 0; b >>= 1) {
+            if (b & 1) {
+                for (size_t i = 0; i < len; ++i) acc[i] *= base[i];
+            }
+            if (b > 1) {
+                for (size_t i = 0; i < len; ++i) base[i] *= base[i];
+            }
+        }
+        if (invert) {
+            for (size_t i = 0; i < len; ++i) out[off + i] = 1.0 / acc[i];
+        }
+        else {
+            for (size_t i = 0; i < len; ++i) out[off + i] = acc[i];
+        }
+    }
+}
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+double sum_exp_shifted(const double* x, size_t n, double shift)
+{
+    double sum {0.0};
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) sum += exp<A>(x[i] - shift);
+    return sum;
+}
+
+template<Accuracy A>
+NUMY_VMATH_CLONES
+double exp_shifted(double* x, size_t n, double shift)
+{
+    double sum {0.0};
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = exp<A>(x[i] - shift);
+        sum += x[i];
+    }
+    return sum;
+}
+
+inline double max_of(const double* x, size_t n)
+{
+    double mx = x[0];
+    for (size_t i = 1; i < n; ++i) mx = (x[i] > mx)? x[i] : mx;
+    return mx;
+}
+
+} // anonymous namespace
+
+void exp(const double* in, double* out, size_t n, Accuracy acc)
+{
+    if (acc == Accuracy::FAST) exp_loop<Accuracy::FAST>(in, out, n);
+    else exp_loop<Accuracy::ULP1>(in, out, n);
+}
+
+void log(const double* in, double* out, size_t n, Accuracy acc)
+{
+    if (acc == Accuracy::FAST) log_loop<Accuracy::FAST>(in, out, n);
+    else log_loop<Accuracy::ULP1>(in, out, n);
+}
+
+void sigmoid(const double* in, double* out, size_t n, Accuracy acc)
+{
+    if (acc == Accuracy::FAST) sigmoid_loop<Accuracy::FAST>(in, out, n);
+    else sigmoid_loop<Accuracy::ULP1>(in, out, n);
+}
+
+void tanh(const double* in, double* out, size_t n, Accuracy acc)
+{
+    if (acc == Accuracy::FAST) tanh_loop<Accuracy::FAST>(in, out, n);
+    else tanh_loop<Accuracy::ULP1>(in, out, n);
+}
+
+/**
+ * Small integer powers are done by repeated squaring, error grows with
+ * number of multiplications, so ULP1 takes only |p| <= 4 this way.
+ * Other powers: FAST goes through exp(p·log x), ULP1 calls std::pow,
+ * exp(p·log x) is not accurate for large p·log x without extended
+ * precision log.
+ */
+void pow(const double* in, double* out, size_t n, double p, Accuracy acc)
+{
+    const double ap = std::abs(p);
+    const double maxInt = (acc == Accuracy::FAST)? 64.0 : 4.0;
+
+    if (p == 0.5) {
+        #pragma GCC ivdep
+        for (size_t i = 0; i < n; ++i) out[i] = std::sqrt(in[i]);
+    }
+    else if (ap == std::floor(ap) and ap <= maxInt) {
+        pow_int_loop(in, out, n, (unsigned) ap, p < 0.0);
+    }
+    else if (acc == Accuracy::FAST) {
+        pow_fast_loop(in, out, n, p);
+    }
+    else {
+        for (size_t i = 0; i < n; ++i) out[i] = std::pow(in[i], p);
+    }
+}
+
+/// Shifted by max element, so exp does not overflow.
+double logsumexp(const double* x, size_t n, Accuracy acc)
+{
+    const double mx = max_of(x, n);
+
+    if (std::isinf(mx)) return mx;
+
+    const double sum = (acc == Accuracy::FAST)?
+        sum_exp_shifted<Accuracy::FAST>(x, n, mx) : sum_exp_shifted<Accuracy::ULP1>(x, n, mx);
+
+    return mx + ((acc == Accuracy::FAST)? log<Accuracy::FAST>(sum) : log<Accuracy::ULP1>(sum));
+}
+
+void softmax(double* x, size_t n, Accuracy acc)
+{
+    const double mx = max_of(x, n);
+
+    const double sum = (acc == Accuracy::FAST)?
+        exp_shifted<Accuracy::FAST>(x, n, mx) : exp_shifted<Accuracy::ULP1>(x, n, mx);
+
+    const double inv = 1.0 / sum;
+    #pragma GCC ivdep
+    for (size_t i = 0; i < n; ++i) x[i] *= inv;
+}
+
+} // namespace numy::vmath
@@ -0,0 +1,216 @@
+/**
+ * @file
+ * @brief     Vectorizable exp, log, tanh, sigmoid, pow.
+ * @author    Igor Lesik 2020
+ * @copyright Igor Lesik 2020
+ *
+ * libm exp/log/pow are opaque calls, a loop over them runs one
+ * element at a time. Functions here are inline, branch-free
+ * (selects instead of ifs) and use only arithmetic and integer bit
+ * operations, so the compiler vectorizes loops over them.
+ *
+ * exp:  x = n ln2 + r, |r| <= ln2/2, e^x = 2^n e^r, e^r by polynomial,
+ *       2^n is built from exponent bits; n is rounded with 1.5·2^52
+ *       shift trick, no double-to-int conversion.
+ * log:  x = 2^e m, sqrt(1/2) <= m < sqrt(2), f = m - 1, s = f/(2+f),
+ *       log(1+f) = 2 atanh(s) as in fdlibm.
+ *
+ * Accuracy::ULP1 polynomials are long enough for about 1 ULP error
+ * in exp and log; tanh and sigmoid combine several rounded operations
+ * and measure up to 3 ULP against correctly rounded results (4 against
+ * libm). Accuracy::FAST ones are shorter and give about 1e-10 relative
+ * error.
+ *
+ * NaN input gives NaN.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace numy::vmath {
+
+enum class Accuracy { ULP1, FAST };
+
+namespace detail {
+
+inline uint64_t bits(double x) { uint64_t u; std::memcpy(&u, &x, sizeof u); return u; }
+inline double from_bits(uint64_t u) { double x; std::memcpy(&x, &u, sizeof x); return x; }
+
+constexpr double LOG2E   = 1.44269504088896338700e+00;
+constexpr double LN2_HI  = 6.93147180369123816490e-01;
+constexpr double LN2_LO  = 1.90821492927058770002e-10;
+constexpr double SHIFT   = 6755399441055744.0; // 1.5·2^52
+constexpr double EXP_MAX = 7.09782712893383973096e+02;
+constexpr double EXP_MIN = -7.452e+02;
+constexpr double SQRT2   = 1.41421356237309504880e+00;
+constexpr double INF     = std::numeric_limits<double>::infinity();
+
+/// e^r - 1 for |r| <= ln2/2, Taylor series evaluated with Estrin's scheme.
+template<Accuracy A>
+inline double expm1_poly(double r)
+{
+    const double r2 = r * r;
+    const double r4 = r2 * r2;
+
+    const double p2 = 1.0 / 2.0 + r * (1.0 / 6.0);
+    const double p4 = 1.0 / 24.0 + r * (1.0 / 120.0);
+    const double p6 = 1.0 / 720.0 + r * (1.0 / 5040.0);
+
+    double p;
+    if constexpr (A == Accuracy::ULP1) {
+        const double p8 = 1.0 / 40320.0 + r * (1.0 / 362880.0);
+        const double p10 = 1.0 / 3628800.0 + r * (1.0 / 39916800.0);
+        const double p12 = 1.0 / 479001600.0 + r * (1.0 / 6227020800.0);
+        p = (p2 + r2 * p4) + r4 * ((p6 + r2 * p8) + r4 * (p10 + r2 * p12));
+    }
+    else {
+        p = (p2 + r2 * p4) + r4 * (p6 + r2 * (1.0 / 40320.0));
+    }
+    return r + r2 * p;
+}
+
+/**
+ * Split x into r and 2^n scale, scale·tail·e^r = e^x.
+ * n is adjusted near the ends of the range, so that scale stays
+ * a normal number, and tail compensates.
+ */
+inline void exp_reduce(double x, double& r, double& scale, double& tail)
+{
+    double xc = (x < EXP_MIN)? EXP_MIN : x;
+    xc = (x > EXP_MAX)? EXP_MAX : xc;
+
+    const double kd = (xc * LOG2E + SHIFT) - SHIFT;
+
+    r = (xc - kd * LN2_HI) - kd * LN2_LO;
+
+    const bool tiny = xc < -708.0;
+    const bool huge = xc > 709.0;
+    double adj = tiny? 64.0 : 0.0;
+    adj = huge? -1.0 : adj;
+    tail = tiny? 0x1p-64 : 1.0;
+    tail = huge? 2.0 : tail;
+
+    // low bits of 1.5·2^52 + n hold n
+    scale = from_bits((bits(kd + adj + SHIFT) + 1023) << 52);
+}
+
+/// sum of 2/(2k+1) z^k, k >= 1, z = s^2
+template<Accuracy A>
+inline double log_poly(double z)
+{
+    const double z2 = z * z;
+    const double z4 = z2 * z2;
+
+    const double p1 = 2.0 / 3.0 + z * (2.0 / 5.0);
+    const double p3 = 2.0 / 7.0 + z * (2.0 / 9.0);
+
+    double p;
+    if constexpr (A == Accuracy::ULP1) {
+        const double p5 = 2.0 / 11.0 + z * (2.0 / 13.0);
+        const double p7 = 2.0 / 15.0 + z * (2.0 / 17.0);
+        const double p9 = 2.0 / 19.0 + z * (2.0 / 21.0);
+        p = (p1 + z2 * p3) + z4 * ((p5 + z2 * p7) + z4 * p9);
+    }
+    else {
+        p = (p1 + z2 * p3) + z4 * (2.0 / 11.0);
+    }
+    return z * p;
+}
+
+} // namespace detail
+
+template<Accuracy A = Accuracy::ULP1>
+inline double exp(double x)
+{
+    double r, scale, tail;
+    detail::exp_reduce(x, r, scale, tail);
+    const double y = (scale + scale * detail::expm1_poly<A>(r)) * tail;
+    return (x > detail::EXP_MAX)? detail::INF : y;
+}
+
+template<Accuracy A = Accuracy::ULP1>
+inline double log(double x)
+{
+    using namespace detail;
+
+    // scale subnormals up
+    const bool sub = x < std::numeric_limits<double>::min();
+    const double xs = x * (sub? 0x1p54 : 1.0);
+    const uint64_t u = bits(xs);
+
+    // exponent as double without int-to-double conversion
+    double e = from_bits(0x4330000000000000ull | ((u >> 52) & 0x7ff)) - (0x1p52 + 1023.0);
+    e -= sub? 54.0 : 0.0;
+
+    double m = from_bits((u & 0x000fffffffffffffull) | 0x3ff0000000000000ull);
+    const bool big = m > SQRT2;
+    m *= big? 0.5 : 1.0;
+    e += big? 1.0 : 0.0;
+
+    const double f = m - 1.0;
+    const double s = f / (2.0 + f);
+    const double hfsq = 0.5 * f * f;
+    const double R = log_poly<A>(s * s);
+
+    const double y = e * LN2_HI - ((hfsq - (s * (hfsq + R) + e * LN2_LO)) - f);
+
+    // NaN bits decode as exponent 1024, select it back
+    double z = (x == INF)? INF : y;
+    z = (x == 0.0)? -INF : z;
+    z = (x < 0.0)? std::numeric_limits<double>::quiet_NaN() : z;
+    return (x != x)? x : z;
+}
+
+template<Accuracy A = Accuracy::ULP1>
+inline double sigmoid(double x)
+{
+    // e^-|x| does not overflow, e/(1+e) keeps tiny results for x < 0
+    const double e = exp<A>(-std::abs(x));
+    const double s = 1.0 / (1.0 + e);
+    return (x < 0.0)? e * s : s;
+}
+
+template<Accuracy A = Accuracy::ULP1>
+inline double tanh(double x)
+{
+    // tanh|x| = (e^2|x| - 1) / (e^2|x| + 1), expm1 keeps small |x| accurate;
+    // |x| > 20 is 1 in double
+    const double a = std::abs(x);
+    const double ac = (a > 20.0)? 20.0 : a;
+
+    double r, scale, tail;
+    detail::exp_reduce(2.0 * ac, r, scale, tail);
+    const double em = (scale - 1.0) + scale * detail::expm1_poly<A>(r);
+
+    const double t = em / (em + 2.0);
+    return std::copysign((a > 20.0)? 1.0 : t, x);
+}
+
+/// x^p for x > 0 through exp and log, edge cases follow from them.
+template<Accuracy A = Accuracy::ULP1>
+inline double pow_exp_log(double x, double p)
+{
+    return exp<A>(p * log<A>(x));
+}
+
+/*
+ * Array versions, `out` may be same as `in`, see vmath.cpp.
+ */
+
+void exp(const double* in, double* out, size_t n, Accuracy acc = Accuracy::ULP1);
+void log(const double* in, double* out, size_t n, Accuracy acc = Accuracy::ULP1);
+void sigmoid(const double* in, double* out, size_t n, Accuracy acc = Accuracy::ULP1);
+void tanh(const double* in, double* out, size_t n, Accuracy acc = Accuracy::ULP1);
+void pow(const double* in, double* out, size_t n, double p, Accuracy acc = Accuracy::ULP1);
+
+/// log(sum(exp(x))) of n > 0 elements.
+double logsumexp(const double* x, size_t n, Accuracy acc = Accuracy::ULP1);
+
+/// In-place softmax of n > 0 elements.
+void softmax(double* x, size_t n, Accuracy acc = Accuracy::ULP1);
+
+} // namespace numy::vmath
@@ -88,4 +88,609 @@ defmodule NumyTest do
     solution = Numy.Lapack.data(b,2*3)
     assert Numy.Float.equal?(solution, [[2,1], [1,1], [1,2]])
   end
+
+  test "tensor binary encode/decode" do
+    alias Numy.Lapack.Vector, as: LVec
+    v = LVec.new(1..100)
+    v2 = LVec.to_binary(v) |> LVec.from_binary
+    assert Numy.Vc.equal?(v, v2)
+    v3 = LVec.to_binary(v, compressed: true) |> LVec.from_binary
+    assert Numy.Vc.equal?(v, v3)
+    t = Numy.Lapack.new_tensor([3,5])
+    assert Numy.Lapack.to_binary(t) |> Numy.Lapack.from_binary |> Map.get(:shape) == [3,5]
+    # too small to compress, stored as is
+    one = LVec.new([7])
+    bin = LVec.to_binary(one, compressed: true)
+    assert byte_size(bin) == 16 + 4 + 8
+    assert LVec.from_binary(bin) |> Numy.Vc.data == [7.0]
+    assert LVec.from_binary("junk") == :error
+  end
+
+  test "tensor decode rejects forged sizes" do
+    # shape [2^29 + 1] is 2^32 + 8 bytes, compressed payload holds only 8
+    n = 0x20000001
+    payload = :zlib.compress(<<0::64>>)
+    header = <<"NUMY", 1, 0, 1, 1, n::little-32, byte_size(payload)::little-32, n::little-32>>
+    assert Numy.Lapack.from_binary(header <> payload) == :error
+    plain = <<"NUMY", 1, 0, 0, 1, n::little-32, 8::little-32, n::little-32, 0::64>>
+    assert Numy.Lapack.from_binary(plain) == :error
+    big = <<"NUMY", 1, 0, 0, 2, 0::little-32, 8::little-32, 0x10000::little-32, 0x10000::little-32, 0::64>>
+    assert Numy.Lapack.from_binary(big) == :error
+  end
+
+  test "save and load tensor file" do
+    path = Path.join(System.tmp_dir!(), "numy_test_vec.bin")
+    v = Numy.Lapack.Vector.new(1..5)
+    assert Numy.Lapack.Vector.save_to_file(v, String.to_charlist(path)) == :ok
+    assert File.read!(path) == Numy.Lapack.Vector.to_binary(v)
+    v2 = Numy.Lapack.Vector.load_from_file(String.to_charlist(path))
+    assert Numy.Vc.data(v2) == [1.0, 2.0, 3.0, 4.0, 5.0]
+    # raw Tensor struct written by older versions
+    legacy = <<0xbadc01dc0ffe::little-64, 0::little-32, 1::little-32, 3::little-32, 0::size(992),
+      0::64, 3::little-32, 24::little-32>> <> <<1.0::float-little, 2.0::float-little, 3.0::float-little>>
+    File.write!(path, legacy)
+    v3 = Numy.Lapack.Vector.load_from_file(String.to_charlist(path))
+    assert Numy.Vc.data(v3) == [1.0, 2.0, 3.0]
+    File.write!(path, "not a tensor file")
+    assert Numy.Lapack.Vector.load_from_file(String.to_charlist(path)) == {:error, :unsupported_format}
+    File.rm(path)
+  end
+
+  test "shared memory tensor" do
+    name = "numy_test_#{System.unique_integer([:positive])}"
+    t = Numy.Lapack.new_shared_tensor(name, [2,3])
+    assert Numy.Lapack.shared_generation(t) == 0
+    Numy.Lapack.update_shared(t, fn t -> Numy.Lapack.assign(t, [1,2,3,4,5,6]) end)
+    assert Numy.Lapack.shared_generation(t) == 2
+    t2 = Numy.Lapack.attach_shared(name)
+    assert t2.shape == [2,3]
+    assert Numy.Float.equal?(Numy.Lapack.data(t2), [1,2,3,4,5,6])
+    assert Numy.Lapack.unlink_shared(name) == :ok
+  end
+
+  test "blas level 1" do
+    alias Numy.Lapack, as: L
+    alias Numy.Lapack.Vector, as: LVec
+    x = LVec.new([1,2,3,4,5,6])
+    y = LVec.new(6)
+    assert L.blas_dcopy(3, x.lapack.nif_resource, 2, y.lapack.nif_resource, 1) == :ok
+    assert Numy.Float.equal?(Numy.Vc.data(y, 3), [1,3,5])
+    assert Numy.Float.equal?(L.blas_ddot(6, x.lapack.nif_resource, 1, x.lapack.nif_resource, 1), 91.0)
+    assert Numy.Float.equal?(L.blas_dasum(3, x.lapack.nif_resource, 2), 9.0)
+    assert L.blas_idamax(6, x.lapack.nif_resource, 1) == 5
+    L.blas_daxpy(6, 2.0, x.lapack.nif_resource, 1, y.lapack.nif_resource, 1)
+    assert Numy.Float.equal?(Numy.Vc.data(y, 3), [3,7,11])
+    assert_raise ArgumentError, fn -> L.blas_dnrm2(7, x.lapack.nif_resource, 1) end
+  end
+
+  test "matrix multiply gemv/gemm" do
+    a = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(a, [[1,2,3],[4,5,6]])
+    x = Numy.Lapack.Vector.new([1,1,1])
+    assert Numy.Float.equal?(Numy.Mx.mul_vector(a, x) |> Numy.Vc.data, [6,15])
+    c = Numy.Lapack.gemm(a, a, transpose_b: true)
+    assert c.shape == [2,2]
+    assert Numy.Float.equal?(Numy.Lapack.data(c), [14,32,32,77])
+    Numy.Lapack.gemm(a, a, transpose_b: true, alpha: 2.0, beta: 1.0, out: c)
+    assert Numy.Float.equal?(Numy.Lapack.data(c), [42,96,96,231])
+  end
+
+  test "batched small matrix multiply" do
+    a = Numy.Lapack.new_tensor([3,3,2])
+    Numy.Lapack.assign(a, [[1,0,0],[0,1,0],[0,0,1], [2,0,0],[0,2,0],[0,0,2]])
+    x = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(x, [[1,2,3],[1,2,3]])
+    y = Numy.Lapack.batch_mul(a, x)
+    assert y.shape == [3,2]
+    assert Numy.Float.equal?(Numy.Lapack.data(y), [1,2,3,2,4,6])
+    c = Numy.Lapack.batch_mul(a, a)
+    assert c.shape == [3,3,2]
+    assert Numy.Float.equal?(Numy.Lapack.data(c, 9), [1,0,0,0,1,0,0,0,1])
+    # 3x4 affine transform of homogeneous points
+    t = Numy.Lapack.new_tensor([4,3])
+    Numy.Lapack.assign(t, [[1,0,0,10],[0,1,0,20],[0,0,1,30]])
+    p = Numy.Lapack.new_tensor([4,2])
+    Numy.Lapack.assign(p, [[1,2,3,1],[4,5,6,1]])
+    assert Numy.Lapack.data(Numy.Lapack.batch_mul(t, p)) == [11.0,22.0,33.0,14.0,25.0,36.0]
+  end
+
+  test "lapack factorize once, solve many" do
+    a = Numy.Lapack.new_tensor([3,5])
+    Numy.Lapack.assign(a, [1,1,1,2,3,4,3,5,2,4,2,5,5,4,3])
+    f = Numy.Lapack.factorize(a, :qr)
+    for _ <- 1..2 do
+      b = Numy.Lapack.new_tensor([2,5])
+      Numy.Lapack.assign(b, [-10,-3,12,14,14,12,16,16,18,16])
+      assert Numy.Lapack.factor_solve(f, b) == 0
+      assert Numy.Float.equal?(Numy.Lapack.data(b,6), [[2,1], [1,1], [1,2]])
+    end
+    s = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(s, [[4,1],[1,3]])
+    for method <- [:lu, :cholesky] do
+      f = Numy.Lapack.factorize(s, method)
+      x = Numy.Lapack.new_tensor([2])
+      Numy.Lapack.assign(x, [1,2])
+      assert Numy.Lapack.factor_solve(f, x) == 0
+      assert Numy.Float.equal?(Numy.Lapack.data(x), [1/11, 7/11])
+    end
+  end
+
+  test "lapack batched LLS" do
+    a_one = [1,1,1,2,3,4,3,5,2,4,2,5,5,4,3]
+    b_one = [-10,-3,12,14,14,12,16,16,18,16]
+    a = Numy.Lapack.new_tensor([3,5,4])
+    Numy.Lapack.assign(a, List.duplicate(a_one, 4))
+    b = Numy.Lapack.new_tensor([2,5,4])
+    Numy.Lapack.assign(b, List.duplicate(b_one, 4))
+    assert Numy.Lapack.solve_lls_batch(a, b) == 0
+    data = Numy.Lapack.data(b)
+    for i <- 0..3 do
+      assert Numy.Float.equal?(Enum.slice(data, i*10, 6), [[2,1], [1,1], [1,2]])
+    end
+  end
+
+  test "lapack LU non-symmetric, many rhs" do
+    a = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(a, [[1,2],[3,4]])
+    f = Numy.Lapack.factorize(a, :lu)
+    for _ <- 1..2 do
+      b = Numy.Lapack.new_tensor([2,2])
+      Numy.Lapack.assign(b, [[5,1],[11,3]])
+      assert Numy.Lapack.factor_solve(f, b) == 0
+      assert Numy.Float.equal?(Numy.Lapack.data(b), [1,1,2,0])
+    end
+  end
+
+  test "eigen decomposition and SVD" do
+    a = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(a, [[2,1],[1,2]])
+    {w, v} = Numy.Lapack.eigh(a)
+    assert Numy.Float.equal?(Numy.Lapack.data(w), [1,3])
+    assert v.shape == [2,2]
+    {w, _} = Numy.Lapack.eigh(a, subset: 1..1)
+    assert Numy.Float.equal?(Numy.Lapack.data(w), [3])
+    m = Numy.Lapack.new_tensor([2,3])
+    Numy.Lapack.assign(m, [[3,0],[0,2],[0,0]])
+    {u, s, vt} = Numy.Lapack.svd(m)
+    assert Numy.Float.equal?(Numy.Lapack.data(s), [3,2])
+    assert u.shape == [2,3] and vt.shape == [2,2]
+    {_, s, _} = Numy.Lapack.randomized_svd(m, 1)
+    assert Numy.Float.equal?(Numy.Lapack.data(s), [3])
+  end
+
+  test "covariance and correlation matrix" do
+    x = Numy.Lapack.new_tensor([3,3])
+    Numy.Lapack.assign(x, [[1,2,3],[2,4,1],[3,6,2]])
+    cov = Numy.Lapack.covariance(x)
+    assert cov.shape == [3,3]
+    assert Numy.Float.equal?(Numy.Lapack.data(cov), [1,2,-0.5, 2,4,-1, -0.5,-1,1])
+    corr = Numy.Lapack.correlation(x)
+    assert Numy.Float.equal?(Numy.Lapack.data(corr), [1,1,-0.5, 1,1,-0.5, -0.5,-0.5,1])
+  end
+
+  test "linear and polynomial regression" do
+    x = Numy.Lapack.new_tensor([4])
+    Numy.Lapack.assign(x, [0,1,2,3])
+    y = Numy.Lapack.new_tensor([4])
+    Numy.Lapack.assign(y, [1,3,5,7])
+    {coef, rss, r2} = Numy.Lapack.poly_fit(x, y, 1)
+    assert Numy.Float.equal?(Numy.Lapack.data(coef), [1,2])
+    assert Numy.Float.equal?(rss, 0.0) and Numy.Float.equal?(r2, 1.0)
+    design = Numy.Lapack.new_tensor([2,4])
+    Numy.Lapack.assign(design, [[1,0],[1,1],[1,2],[1,3]])
+    {coef, _, _} = Numy.Lapack.linear_fit(design, y, weights: y)
+    assert Numy.Float.equal?(Numy.Lapack.data(coef), [1,2])
+    {coef, _, r2} = Numy.Lapack.poly_fit(x, y, 1, ridge: 1.0)
+    assert Enum.at(Numy.Lapack.data(coef), 1) < 2.0 and r2 < 1.0
+  end
+
+  test "online least squares" do
+    state = Numy.Lapack.online_fit(2)
+    assert {:error, _} = Numy.Lapack.online_solve(state)
+    x = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(x, [[1,0],[1,1]])
+    y = Numy.Lapack.new_tensor([2])
+    Numy.Lapack.assign(y, [1,3])
+    assert Numy.Lapack.online_update(state, x, y) == :ok
+    Numy.Lapack.assign(x, [[1,2],[1,3]])
+    Numy.Lapack.assign(y, [5,7])
+    assert Numy.Lapack.online_update(state, x, y) == :ok
+    {coef, rss, count} = Numy.Lapack.online_solve(state)
+    assert Numy.Float.equal?(Numy.Lapack.data(coef), [1,2])
+    assert Numy.Float.equal?(rss, 0.0) and Numy.Float.equal?(count, 4.0)
+    # p×p R would not fit
+    assert Numy.Lapack.online_fit(65536) == :error
+  end
+
+  test "B-spline fit and eval" do
+    x = Numy.Lapack.new_tensor([20])
+    Numy.Lapack.assign(x, Enum.map(0..19, &(&1 / 19)))
+    y = Numy.Lapack.new_tensor([20])
+    Numy.Lapack.assign(y, Enum.map(0..19, &(2 * &1 / 19 + 1)))
+    solver = Numy.SL.new_bspline(6)
+    {_chisq, r2, dof} = Numy.SL.fit_bspline(solver, x, y)
+    assert Numy.Float.equal?(r2, 1.0) and dof == 14.0
+    q = Numy.Lapack.new_tensor([2])
+    Numy.Lapack.assign(q, [0.25, 0.5])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.eval_bspline(solver, q)), [1.5, 2.0])
+    Numy.Lapack.assign(q, [-1.0, 2.0])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.eval_bspline(solver, q)), [1.0, 3.0])
+    assert Numy.Lapack.data(Numy.SL.eval_bspline(solver, q, outside: 0)) == [0.0, 0.0]
+  end
+
+  test "interpolation" do
+    x = Numy.Lapack.new_tensor([5])
+    Numy.Lapack.assign(x, [0,1,2,3,4])
+    y = Numy.Lapack.new_tensor([5])
+    Numy.Lapack.assign(y, [0,2,4,6,8])
+    q = Numy.Lapack.new_tensor([3])
+    for type <- [:linear, :cspline, :akima] do
+      interp = Numy.SL.new_interp(x, y, type)
+      Numy.Lapack.assign(q, [0.5, 1.5, 3.25])
+      assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.interp(interp, q)), [1, 3, 6.5])
+      Numy.Lapack.assign(q, [3.25, 0.5, 1.5])
+      assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.interp(interp, q)), [6.5, 1, 3])
+      Numy.Lapack.assign(q, [-1, 2, 5])
+      assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.interp(interp, q)), [0, 4, 8])
+      assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.interp(interp, q, outside: -1)), [-1, 4, -1])
+    end
+  end
+
+  test "FFT, convolution and correlation" do
+    x = Numy.Lapack.new_tensor([4])
+    Numy.Lapack.assign(x, [1,2,3,4])
+    z = Numy.SL.rfft(x)
+    assert z.shape == [2,3]
+    assert Numy.Float.equal?(Numy.Lapack.data(z), [10,0, -2,2, -2,0])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.irfft(z, 4)), [1,2,3,4])
+    k = Numy.Lapack.new_tensor([2])
+    Numy.Lapack.assign(k, [1,1])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.convolve(x, k)), [1,3,5,7,4])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.SL.convolve(x, k, :valid)), [3,5,7])
+    long = Numy.Lapack.new_tensor([100])
+    Numy.Lapack.assign(long, List.duplicate(1, 100))
+    c = Numy.SL.correlate(long, long)
+    assert c.shape == [199]
+    assert Numy.Float.equal?(Enum.at(Numy.Lapack.data(c), 99), 100.0, 1.0e-6)
+  end
+
+  test "broadcasting elementwise ops" do
+    a = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(a, [[1,2,3],[4,5,6]])
+    row = Numy.Lapack.new_tensor([3])
+    Numy.Lapack.assign(row, [10,20,30])
+    Numy.Lapack.vector_add(a.nif_resource, row.nif_resource)
+    assert Numy.Float.equal?(Numy.Lapack.data(a), [11,22,33,14,25,36])
+    col = Numy.Lapack.new_tensor([1,2])
+    Numy.Lapack.assign(col, [[2],[4]])
+    Numy.Lapack.vector_mul(a.nif_resource, col.nif_resource)
+    assert Numy.Float.equal?(Numy.Lapack.data(a), [22,44,66,56,100,144])
+    bad = Numy.Lapack.new_tensor([2])
+    assert_raise ArgumentError, fn -> Numy.Lapack.vector_sub(a.nif_resource, bad.nif_resource) end
+  end
+
+  test "axis reductions" do
+    m = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(m, [[1,2,3],[4,5,6]])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.Lapack.reduce(m, :sum, [0])), [6,15])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.Lapack.reduce(m, :mean, [1])), [2.5,3.5,4.5])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.Lapack.reduce(m, :max)), [6])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.Lapack.reduce(m, :argmax, [0])), [2,2])
+    assert Numy.Float.equal?(Numy.Lapack.data(Numy.Lapack.reduce(m, :norm, [1])),
+      [:math.sqrt(17), :math.sqrt(29), :math.sqrt(45)])
+    # slowest axis of wide matrix, rows are split between threads
+    w = Numy.Lapack.new_tensor([2000,64])
+    Numy.Lapack.assign(w, for(r <- 0..63, do: Enum.to_list(r..(r + 1999))))
+    assert Numy.Lapack.data(Numy.Lapack.reduce(w, :sum, [1])) == Enum.map(0..1999, &(64.0 * &1 + 2016))
+    assert Numy.Lapack.data(Numy.Lapack.reduce(w, :argmax, [1])) == List.duplicate(63.0, 2000)
+  end
+
+  test "transpose, permute and reshape" do
+    m = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(m, [[1,2,3],[4,5,6]])
+    t = Numy.Lapack.transpose(m)
+    assert t.shape == [2,3]
+    assert Numy.Lapack.data(t) == [1.0,4.0,2.0,5.0,3.0,6.0]
+    assert Numy.Lapack.data(Numy.Lapack.transpose(t)) == Numy.Lapack.data(m)
+
+    big = Numy.Lapack.new_tensor([70,50])
+    Numy.Lapack.assign(big, Enum.map(0..49, fn r -> Enum.map(0..69, fn c -> r * 70 + c end) end))
+    bt = Numy.Lapack.transpose(big) |> Numy.Lapack.data
+    assert Enum.at(bt, 1 * 50 + 2) == 2.0 * 70 + 1
+
+    c = Numy.Lapack.new_tensor([2,3,2])
+    Numy.Lapack.assign(c, Enum.map(0..11, &(&1 * 1.0)))
+    p = Numy.Lapack.permute(c, [2,0,1])
+    assert p.shape == [2,2,3]
+    assert Enum.take(Numy.Lapack.data(p), 4) == [0.0, 6.0, 1.0, 7.0]
+    assert Enum.take(Numy.Lapack.permute(c, [0,2,1]) |> Numy.Lapack.data, 4) == [0.0, 1.0, 6.0, 7.0]
+    assert Numy.Lapack.permute(c, [0,0,1]) == :error
+
+    r = Numy.Lapack.reshape(m, [6])
+    assert r.shape == [6]
+    assert Numy.Lapack.data(r) == [1.0,2.0,3.0,4.0,5.0,6.0]
+    assert Numy.Lapack.reshape(m, [4]) == :error
+    # old struct keeps its shape, data is shared
+    assert Numy.Lapack.tensor_shape(m.nif_resource) == [3,2]
+    assert Numy.Lapack.data(Numy.Lapack.transpose(m)) == [1.0,4.0,2.0,5.0,3.0,6.0]
+    Numy.Lapack.assign(r, [6,5,4,3,2,1])
+    assert Numy.Lapack.data(m) == [6.0,5.0,4.0,3.0,2.0,1.0]
+    assert Numy.Lapack.reshape(r, [2,3]).shape == [2,3]
+    # view shares data, so it can't be output of product of its owner
+    sq = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(sq, [[1,2],[3,4]])
+    assert Numy.Lapack.gemm(sq, sq, out: Numy.Lapack.reshape(sq, [2,2])) == :error
+    one = Numy.Lapack.new_tensor([1,1])
+    Numy.Lapack.assign(one, [2])
+    assert Numy.Lapack.gemv(one, Numy.Lapack.new_tensor([1]), out: Numy.Lapack.reshape(one, [1])) == :error
+    assert Numy.Lapack.batch_mul(sq, Numy.Lapack.reshape(sq, [2,2]), Numy.Lapack.reshape(sq, [2,2])) == :error
+  end
+
+  test "fused expressions" do
+    alias Numy.Lapack.Expr
+    x = Numy.Lapack.new_tensor([4])
+    Numy.Lapack.assign(x, [1,2,3,4])
+    y = Numy.Lapack.new_tensor([4])
+    Numy.Lapack.assign(y, [4,3,2,1])
+    r = Expr.eval({:+, {:*, {:arg, 0}, 2}, {:arg, 1}}, [x, y])
+    assert r.shape == [4]
+    assert Numy.Lapack.data(r) == [6.0, 7.0, 8.0, 9.0]
+    assert Expr.eval({:sum, {:>, {:arg, 0}, {:arg, 1}}}, [x, y]) == 2.0
+    assert Expr.eval({:max, {:abs, {:-, {:arg, 0}, 10}}}, [x]) == 9.0
+    assert Expr.eval({:mean, {:pow, {:arg, 0}, 2}}, [x]) == 7.5
+    expr = Expr.compile({:sum, {:sigmoid, {:neg, {:arg, 0}}}})
+    assert_in_delta Expr.eval(expr, [x]), Enum.sum(Enum.map(1..4, fn v -> 1/(1 + :math.exp(v)) end)), 1.0e-12
+    assert Expr.eval({:+, {:arg, 1}, 1}, [x]) == :error
+
+    v = Numy.Lapack.Vector.new(Enum.to_list(1..1000))
+    assert_in_delta Numy.Fit.SimpleLinear.variance(v), Numy.Fit.SimpleLinear.variance(Numy.Vector.new(Enum.to_list(1..1000))), 1.0e-6
+  end
+
+  test "vectorized exp, log, tanh, sigmoid, softmax" do
+    xs = [-3.0, -0.5, 0.0, 0.25, 1.0, 10.0]
+    for {fun, ref} <- [exp: &:math.exp/1, tanh: &:math.tanh/1,
+                       sigmoid: fn x -> 1.0 / (1.0 + :math.exp(-x)) end],
+        accuracy <- [:accurate, :fast] do
+      t = Numy.Lapack.new_tensor([6])
+      Numy.Lapack.assign(t, xs)
+      Numy.Lapack.apply!(t, fun, accuracy)
+      Enum.zip(Numy.Lapack.data(t), xs) |> Enum.each(fn {y, x} ->
+        assert_in_delta y, ref.(x), 1.0e-9 * max(1.0, abs(ref.(x)))
+      end)
+    end
+
+    t = Numy.Lapack.new_tensor([3])
+    Numy.Lapack.assign(t, [0.5, 1.0, 100.0])
+    Enum.zip(Numy.Lapack.apply!(t, :log) |> Numy.Lapack.data, [0.5, 1.0, 100.0]) |> Enum.each(fn {y, x} ->
+      assert_in_delta y, :math.log(x), 1.0e-15
+    end)
+
+    m = Numy.Lapack.new_tensor([3,2])
+    Numy.Lapack.assign(m, [[1,2,3],[1000,1000,1000]])
+    lse = Numy.Lapack.logsumexp(m) |> Numy.Lapack.data
+    assert_in_delta Enum.at(lse, 0), :math.log(:math.exp(1) + :math.exp(2) + :math.exp(3)), 1.0e-12
+    assert_in_delta Enum.at(lse, 1), 1000 + :math.log(3), 1.0e-9
+    Numy.Lapack.apply!(m, :softmax)
+    [a, b, c, d, e, f] = Numy.Lapack.data(m)
+    assert_in_delta a + b + c, 1.0, 1.0e-12
+    assert_in_delta d, 1/3, 1.0e-12
+    assert_in_delta e + f, 2/3, 1.0e-12
+    assert Numy.Lapack.apply!(m, :exp, :wrong) == :error
+
+    for accuracy <- [:accurate, :fast] do
+      p = Numy.Lapack.new_tensor([3])
+      Numy.Lapack.assign(p, [0.5, 2.0, 9.0])
+      Enum.zip(Numy.Lapack.apply!(p, {:pow, 1.7}, accuracy) |> Numy.Lapack.data, [0.5, 2.0, 9.0])
+      |> Enum.each(fn {y, x} -> assert_in_delta y, :math.pow(x, 1.7), 1.0e-9 * :math.pow(x, 1.7) end)
+    end
+
+    # NaN of 0/0 stays NaN; tanh maps +-inf to +-1, only NaN fails `data`
+    for fun <- [:log, :exp, :sigmoid, {:pow, 2.5}, {:pow, 3}], accuracy <- [:accurate, :fast] do
+      t = Numy.Lapack.new_tensor([2])
+      Numy.Lapack.assign(t, [4, 0])
+      d = Numy.Lapack.new_tensor([2])
+      Numy.Lapack.assign(d, [1, 0])
+      :ok = Numy.Lapack.vector_div(t.nif_resource, d.nif_resource)
+      Numy.Lapack.apply!(t, fun, accuracy) |> Numy.Lapack.apply!(:tanh)
+      assert is_list(Numy.Lapack.data(t, 1))
+      assert Numy.Lapack.data(t) == :error
+    end
+  end
+
+  test "prefix scans and differences" do
+    t = Numy.Lapack.new_tensor([5])
+    Numy.Lapack.assign(t, [3,1,4,1,5])
+    assert Numy.Lapack.cumulative(t, :sum) |> Numy.Lapack.data == [3.0, 4.0, 8.0, 9.0, 14.0]
+    assert Numy.Lapack.cumulative(t, :sum, true) |> Numy.Lapack.data == [0.0, 3.0, 4.0, 8.0, 9.0]
+    assert Numy.Lapack.cumulative(t, :prod) |> Numy.Lapack.data == [3.0, 3.0, 12.0, 12.0, 60.0]
+    assert Numy.Lapack.cumulative(t, :max) |> Numy.Lapack.data == [3.0, 3.0, 4.0, 4.0, 5.0]
+    assert Numy.Lapack.cumulative(t, :min) |> Numy.Lapack.data == [3.0, 1.0, 1.0, 1.0, 1.0]
+    assert Numy.Lapack.diff(t) |> Numy.Lapack.data == [-2.0, 3.0, -3.0, 4.0]
+    assert Numy.Lapack.diff(t, 2) |> Numy.Lapack.data == [5.0, -6.0, 7.0]
+    assert Numy.Lapack.diff(t, 5) == :error
+
+    m = Numy.Lapack.new_tensor([2,2])
+    Numy.Lapack.assign(m, [[1,2],[3,4]])
+    assert Numy.Lapack.cumulative!(m, :sum) |> Numy.Lapack.data == [1.0, 3.0, 3.0, 7.0]
+
+    n = 200_000
+    big = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(big, List.duplicate(0.1, n))
+    sums = Numy.Lapack.cumulative(big, :sum) |> Numy.Lapack.data
+    assert_in_delta List.last(sums), n * 0.1, 1.0e-9
+    assert_in_delta Enum.at(sums, 99_999), 10_000.0, 1.0e-9
+  end
+
+  test "rolling window statistics" do
+    xs = [4, 8, 6, -1, -2, -3, -1, 3, 4, 5]
+    t = Numy.Lapack.new_tensor([10])
+    Numy.Lapack.assign(t, xs)
+    windows = Enum.chunk_every(xs, 3, 1, :discard)
+    mean = fn w -> Enum.sum(w) / length(w) end
+    var = fn w -> m = mean.(w); Enum.sum(Enum.map(w, &((&1 - m) * (&1 - m)))) / (length(w) - 1) end
+
+    assert Numy.Lapack.rolling(t, :sum, 3) |> Numy.Lapack.data == Enum.map(windows, &(Enum.sum(&1) * 1.0))
+    assert Numy.Lapack.rolling(t, :min, 3) |> Numy.Lapack.data == Enum.map(windows, &(Enum.min(&1) * 1.0))
+    assert Numy.Lapack.rolling(t, :max, 3) |> Numy.Lapack.data == Enum.map(windows, &(Enum.max(&1) * 1.0))
+    Enum.zip(Numy.Lapack.rolling(t, :mean, 3) |> Numy.Lapack.data, windows)
+    |> Enum.each(fn {y, w} -> assert_in_delta y, mean.(w), 1.0e-12 end)
+    Enum.zip(Numy.Lapack.rolling(t, :var, 3) |> Numy.Lapack.data, windows)
+    |> Enum.each(fn {y, w} -> assert_in_delta y, var.(w), 1.0e-12 end)
+
+    assert Numy.Lapack.rolling(t, :sum, 3, step: 4) |> Numy.Lapack.data == [18.0, -6.0]
+    assert Numy.Lapack.rolling(t, :sum, 3, min_periods: 1) |> Numy.Lapack.data |> Enum.take(3) == [4.0, 12.0, 18.0]
+    assert Numy.Lapack.rolling(t, :sum, 0) == :error
+    assert Numy.Lapack.rolling(t, :median, 3) == :error
+  end
+
+  # indexes of NaN and inf among n elements, float patterns do not match them
+  defp non_finite(t, n) do
+    bin = Numy.Lapack.to_binary(t)
+    payload = binary_part(bin, byte_size(bin) - 8 * n, 8 * n)
+    for {bits, i} <- Enum.with_index(for <<x::little-64 <- payload>>, do: x),
+        match?(<<_::1, 0x7ff::11, _::52>>, <<bits::64>>), do: i
+  end
+
+  # tensor of xs with NaN (0/0) at nan_at
+  defp with_nan(xs, nan_at) do
+    n = length(xs)
+    t = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(t, List.replace_at(xs, nan_at, 0))
+    d = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(d, List.replace_at(List.duplicate(1, n), nan_at, 0))
+    :ok = Numy.Lapack.vector_div(t.nif_resource, d.nif_resource)
+    t
+  end
+
+  test "rolling window with NaN" do
+    t = with_nan(Enum.to_list(1..20), 5)
+    for op <- [:sum, :mean, :var, :std] do
+      assert Numy.Lapack.rolling(t, op, 3) |> non_finite(18) == [3, 4, 5]
+    end
+    assert Numy.Lapack.rolling(t, :sum, 3) |> Numy.Lapack.data(3) == [6.0, 9.0, 12.0]
+    assert Numy.Lapack.rolling(t, :var, 3, step: 2) |> non_finite(9) == [2]
+  end
+
+  test "rolling window over row longer than one thread chunk" do
+    n = 40_000
+    t = with_nan(Enum.to_list(1..n), 35_000)
+    sums = Numy.Lapack.rolling(t, :sum, 4)
+    assert non_finite(sums, n - 3) == [34_997, 34_998, 34_999, 35_000]
+    assert Numy.Lapack.data(sums, 34_997) == Enum.map(1..34_997, &(4.0 * &1 + 6))
+    var = Numy.Lapack.rolling(t, :var, 4)
+    assert non_finite(var, n - 3) == [34_997, 34_998, 34_999, 35_000]
+    Numy.Lapack.data(var, 34_997) |> Enum.each(&assert_in_delta(&1, 5 / 3, 1.0e-6))
+  end
+
+  test "exponential smoothing" do
+    xs = [5, 7, 6, 9, 12, 10, 11, 15]
+    t = Numy.Lapack.new_tensor([8])
+    Numy.Lapack.assign(t, xs)
+
+    {mean, var, state} = Numy.Lapack.ewm(t, 0.3)
+    {m, v} = Enum.reduce(tl(xs), {[5.0], [0.0]}, fn x, {[m | _] = ms, [v | _] = vs} ->
+      d = x - m
+      {[m + 0.3 * d | ms], [0.7 * (v + 0.3 * d * d) | vs]}
+    end)
+    Enum.zip(Numy.Lapack.data(mean), Enum.reverse(m)) |> Enum.each(fn {a, b} -> assert_in_delta a, b, 1.0e-12 end)
+    Enum.zip(Numy.Lapack.data(var), Enum.reverse(v)) |> Enum.each(fn {a, b} -> assert_in_delta a, b, 1.0e-12 end)
+    assert Numy.Lapack.data(state) == [hd(Numy.Lapack.data(mean) |> Enum.reverse), hd(Numy.Lapack.data(var) |> Enum.reverse)]
+
+    # two batches with carried state are same as one
+    {first, second} = Enum.split(xs, 3)
+    t1 = Numy.Lapack.new_tensor([3])
+    Numy.Lapack.assign(t1, first)
+    t2 = Numy.Lapack.new_tensor([5])
+    Numy.Lapack.assign(t2, second)
+    {_, _, s1} = Numy.Lapack.ewm(t1, 0.3)
+    {mean2, _, _} = Numy.Lapack.ewm(t2, 0.3, s1)
+    Enum.zip(Numy.Lapack.data(mean2), Numy.Lapack.data(mean) |> Enum.drop(3))
+    |> Enum.each(fn {a, b} -> assert_in_delta a, b, 1.0e-12 end)
+
+    {level, hstate} = Numy.Lapack.holt(t, 0.5, 0.2)
+    {_, h1} = Numy.Lapack.holt(t1, 0.5, 0.2)
+    {level2, hstate2} = Numy.Lapack.holt(t2, 0.5, 0.2, h1)
+    Enum.zip(Numy.Lapack.data(level2), Numy.Lapack.data(level) |> Enum.drop(3))
+    |> Enum.each(fn {a, b} -> assert_in_delta a, b, 1.0e-12 end)
+    Enum.zip(Numy.Lapack.data(hstate2), Numy.Lapack.data(hstate))
+    |> Enum.each(fn {a, b} -> assert_in_delta a, b, 1.0e-12 end)
+
+    # rows of 2-D tensor are independent series
+    batch = Numy.Lapack.new_tensor([8, 2])
+    Numy.Lapack.assign(batch, xs ++ Enum.map(xs, &(-&1)))
+    {bmean, _, bstate} = Numy.Lapack.ewm(batch, 0.3)
+    assert Numy.Lapack.data(bmean) |> Enum.take(8) == Numy.Lapack.data(mean)
+    assert bstate.shape == [2, 2]
+
+    assert Numy.Lapack.ewm(t, 0.0) == :error
+    assert Numy.Lapack.holt(t, 0.5, 1.5) == :error
+    assert Numy.Lapack.ewm(batch, 0.3, state) == :error
+  end
+
+  test "histogram and digitize" do
+    xs = [0.5, 1, 1.5, 2, 3.99, 4, 7, -1]
+    t = Numy.Lapack.new_tensor([8])
+    Numy.Lapack.assign(t, xs)
+
+    assert Numy.Lapack.histogram(t, {0, 4, 4}) |> Numy.Lapack.data == [1.0, 2.0, 1.0, 2.0]
+
+    edges = Numy.Lapack.new_tensor([3])
+    Numy.Lapack.assign(edges, [0, 1, 10])
+    w = Numy.Lapack.new_tensor([8])
+    Numy.Lapack.assign(w, [1, 2, 3, 4, 5, 6, 7, 8])
+    assert Numy.Lapack.histogram(t, edges, weights: w) |> Numy.Lapack.data == [1.0, 27.0]
+
+    assert Numy.Lapack.digitize(t, edges) |> Numy.Lapack.data == [1.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 0.0]
+    assert Numy.Lapack.digitize(t, edges, right: true) |> Numy.Lapack.data == [1.0, 1.0, 2.0, 2.0, 2.0, 2.0, 2.0, 0.0]
+    assert Numy.Lapack.digitize(t, {0, 4, 4}) |> Numy.Lapack.data == [1.0, 2.0, 2.0, 3.0, 4.0, 5.0, 5.0, 0.0]
+
+    # rows get separate histograms
+    batch = Numy.Lapack.new_tensor([4, 2])
+    Numy.Lapack.assign(batch, [0, 0, 1, 1, 1, 1, 1, 0])
+    h = Numy.Lapack.histogram(batch, {0, 1, 2})
+    assert h.shape == [2, 2]
+    assert Numy.Lapack.data(h) == [2.0, 2.0, 1.0, 3.0]
+
+    n = 300_000
+    big = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(big, Enum.map(0..(n - 1), &rem(&1, 10)))
+    assert Numy.Lapack.histogram(big, {0, 10, 10}) |> Numy.Lapack.data == List.duplicate(n / 10, 10)
+
+    assert Numy.Lapack.histogram(t, {4, 0, 4}) == :error
+    Numy.Lapack.assign(edges, [0, 10, 1])
+    assert Numy.Lapack.histogram(t, edges) == :error
+  end
+
+  test "segment reduce by group id" do
+    t = Numy.Lapack.new_tensor([8])
+    Numy.Lapack.assign(t, [1, 2, 3, 4, 5, 6, 7, 8])
+    ids = Numy.Lapack.new_tensor([8])
+    Numy.Lapack.assign(ids, [2, 0, 2, 5, 0, 2, 5, 2])
+
+    reduce = fn op ->
+      {groups, results} = Numy.Lapack.segment_reduce(t, ids, op)
+      assert Numy.Lapack.data(groups) == [0.0, 2.0, 5.0]
+      Numy.Lapack.data(results)
+    end
+    assert reduce.(:sum) == [7.0, 18.0, 11.0]
+    assert reduce.(:mean) == [3.5, 4.5, 5.5]
+    assert reduce.(:count) == [2.0, 4.0, 2.0]
+    assert reduce.(:min) == [2.0, 1.0, 4.0]
+    assert reduce.(:max) == [5.0, 8.0, 7.0]
+
+    # sorted ids, long enough to be split between threads
+    n = 300_000
+    big = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(big, List.duplicate(1, n))
+    sorted = Numy.Lapack.new_tensor([n])
+    Numy.Lapack.assign(sorted, Enum.map(0..(n - 1), &div(&1, 1000)))
+    {groups, counts} = Numy.Lapack.segment_reduce(big, sorted, :sum)
+    assert Numy.Lapack.data(groups) == Enum.map(0..299, &(&1 * 1.0))
+    assert Numy.Lapack.data(counts) == List.duplicate(1000.0, 300)
+
+    Numy.Lapack.assign(ids, [2, 0, 2.5, 5, 0, 2, 5, 2])
+    assert Numy.Lapack.segment_reduce(t, ids, :sum) == :error
+    assert Numy.Lapack.segment_reduce(t, big, :sum) == :error
+    assert Numy.Lapack.segment_reduce(t, t, :median) == :error
+  end
 end